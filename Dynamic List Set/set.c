@@ -8,6 +8,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <limits.h>
+#include <string.h>
 
 #include "set.h"
 #include "error.h"
@@ -15,6 +16,149 @@
 /* Referenzaehler fuer die gespeicherten Intervalllistenelemente */
 int setlist_refs = 0;
 
+/* Zaehler der Instrumentierung */
+static SetStats stats;
+
+/* Art der gerade ausgefuehrten Operation, der Allokationen zugerechnet werden */
+static SetStatsOp statsOp = SET_STATS_BUILD;
+
+/** Anzahl der Bits eines Bitmap-Worts */
+#define WORD_BITS (sizeof(unsigned long) * CHAR_BIT)
+
+/** Anzahl der Worte der Bitmap eines Blocks */
+#define CHUNK_WORDS (SET_CHUNK_BITS / WORD_BITS)
+
+/** kleinstes Element eines Knotens */
+#define NODE_FIRST(NODE) ((NODE)->starts[0])
+
+/** groesstes Element eines Knotens */
+#define NODE_LAST(NODE) ((NODE)->ends[(NODE)->count - 1])
+
+/** Groesse der Bitmap eines Blocks in Bytes */
+#define CHUNK_BYTES (CHUNK_WORDS * sizeof(unsigned long))
+
+/**
+ * Liefert die Klasse einer Anzahl in den Haeufigkeitsverteilungen: 0 fuer 0,
+ * sonst k fuer Anzahlen von 2^(k-1) bis 2^k - 1.
+ *
+ * @param[in] n die Anzahl.
+ *
+ * @return die Klasse.
+ */
+static unsigned int
+statsBucket (unsigned long n) {
+    unsigned int k = 0;
+
+    while(n != 0 && k < SET_STATS_BUCKETS - 1){
+        n >>= 1;
+        k++;
+    }
+    return k;
+}
+
+/**
+ * Beginnt eine Operation, der die folgenden Allokationen zugerechnet werden.
+ * Innerhalb einer anderen Operation (z.B. der Verknuepfung beim Einfuegen)
+ * bleibt die aeussere Operation bestehen.
+ *
+ * @param[in] op die Operation.
+ *
+ * @return die bisherige Operation, ist an statsLeave zu uebergeben.
+ */
+static SetStatsOp
+statsEnter (SetStatsOp op) {
+    SetStatsOp outer = statsOp;
+
+    if (outer == SET_STATS_BUILD) {
+        statsOp = op;
+        stats.calls[op]++;
+    }
+    return outer;
+}
+
+/**
+ * Beendet eine mit statsEnter begonnene Operation.
+ *
+ * @param[in] outer die von statsEnter gelieferte Operation.
+ */
+static void
+statsLeave (SetStatsOp outer) {
+    statsOp = outer;
+}
+
+/**
+ * Fordert Speicher an und zaehlt die Allokation. Bei Speichermangel wird das
+ * Programm beendet.
+ *
+ * @param[in,out] counters die Zaehler (&stats oder die eines Builders).
+ * @param[in]     bytes    die Groesse in Bytes.
+ * @param[in]     clear    1, falls der Speicher mit 0 initialisiert werden soll.
+ *
+ * @return der Speicher.
+ */
+static void *
+allocate (SetStats * counters, size_t bytes, int clear) {
+    void * p = clear ? calloc(1, bytes) : malloc(bytes);
+
+    if (p == NULL) {
+        exit(ERR_OUT_OF_MEMORY);
+    }
+    counters->allocations++;
+    counters->allocs[statsOp]++;
+    counters->bytesInUse += bytes;
+    if (counters->bytesInUse > counters->peakBytes) {
+        counters->peakBytes = counters->bytesInUse;
+    }
+    return p;
+}
+
+/**
+ * Gibt mit allocate angeforderten Speicher frei.
+ *
+ * @param[in] p     der Speicher oder NULL.
+ * @param[in] bytes die Groesse in Bytes.
+ */
+static void
+release (void * p, size_t bytes) {
+    if (p != NULL) {
+        free(p);
+        stats.releases++;
+        stats.bytesInUse -= bytes;
+    }
+}
+
+/**
+ * Erzeugt ein neuen Knoten mit einem uebergebenen Intervall und zaehlt ihn
+ * in den uebergebenen Zaehlern.
+ *
+ * @param[in,out] counters die Zaehler (&stats oder die eines Builders).
+ * @param[in]     start    der Anfang des Intervalls.
+ * @param[in]     end      das Ende des Intervalls.
+ * @param[in]     next     Zeiger auf das naechste Element
+ *
+ * @return ein neuer Knoten mit dem Intervall von start bis end.
+ */
+static Set
+createNode (SetStats * counters, Element start, Element end, Set next) {
+    Set s = allocate(counters, sizeof(struct Intervall), 0);
+
+    s->starts[0] = start;
+    s->ends[0] = end; 
+    s->count = 1;
+    s->next = next;
+    s->refs = 1;
+    s->bits = NULL;
+    if (counters == &stats) {
+        setlist_refs++;
+    }
+    counters->liveNodes++;
+    if (counters->liveNodes > counters->peakNodes) {
+        counters->peakNodes = counters->liveNodes;
+    }
+    
+    return s;
+}
+
 /**
  * Erzeugt ein neuen Knoten mit einem uebergebenen Intervall. 
  *
@@ -26,210 +170,495 @@ int setlist_refs = 0;
  */
 Set
 createIntervall(Element start, Element end, Set next) {
-    Set s = malloc(sizeof(struct Intervall));
-    if(s == NULL){
-        exit(ERR_OUT_OF_MEMORY);
-    }
-    s->start = start;
-    s->end = end; 
-    s->next = next;
-    setlist_refs++;
-    
+    return createNode(&stats, start, end, next);
+}
+
+/**
+ * Erzeugt einen neuen Bitmap-Knoten.
+ *
+ * @param[in,out] counters die Zaehler (&stats oder die eines Builders).
+ * @param[in] start kleinstes Element der Bitmap.
+ * @param[in] end   groesstes Element der Bitmap.
+ * @param[in] bits  die Bitmap des Blocks, geht in den Besitz des Knotens ueber.
+ * @param[in] next  Zeiger auf das naechste Element
+ *
+ * @return ein neuer Bitmap-Knoten.
+ */
+static Set
+createChunk (SetStats * counters, Element start, Element end, unsigned long * bits, Set next) {
+    Set s = createNode(counters, start, end, next);
+
+    s->bits = bits;
+    counters->liveBitmaps++;
     return s;
 }
 
 /**
- * Erzeugt ein neuen Knoten mit einem Element. 
+ * Gibt einen Knoten samt seiner Bitmap frei.
  *
- * @param[in] e Das neue Element.
+ * @param[in] node der Knoten.
+ */
+static void
+freeNode (Set node) {
+    if (node->bits != NULL) {
+        release(node->bits, CHUNK_BYTES);
+        stats.liveBitmaps--;
+    }
+    release(node, sizeof(struct Intervall));
+    setlist_refs--;
+    stats.liveNodes--;
+}
+
+/**
+ * Gibt die Referenz auf den Listenanfang s auf. Knoten werden nur freigegeben,
+ * solange sie nicht noch von einer Kopie verwendet werden.
  *
- * @return ein neuer Knoten mit dem Element e.
+ * @param[in] s der Listenanfang.
  */
-Set
-createSingleIntervall(long e) {
-    Set s = malloc(sizeof(struct Intervall));
-    if(s == NULL){
-        exit(ERR_OUT_OF_MEMORY);
+static void
+releaseList (Set s) {
+    while(!SET_IS_EMPTY(s) && --s->refs == 0){
+        Set toFree = s;
+        s = s->next;
+        freeNode(toFree);
     }
-    s->start = e;
-    s->end = e;
-    s->next = EMPTY_SET;
-    setlist_refs++;
-    return s;
 }
 
 /**
- * Fuegt ein neues Element an den uebergebenen Knoten an. 
+ * Liefert das erste Element des Blocks, in dem e liegt.
  *
- * @param[in] curr Zeiger auf den aktuellen Knoten.
- * @param[in] e    Das neue Element.
+ * @param[in] e das Element.
  *
- * @return der Knoten curr mit dem neuen Element e.
+ * @return erstes Element des Blocks.
  */
-Set
-addSingleIntervall(Set curr, long e){
-    if(e == curr->end + 1) {
-        curr->end = e;
-    } else if(e == curr->start -1) {
-        curr->start = e;
-    } else{
-        curr->next = createSingleIntervall(e);
-        curr = curr->next;
+static Element
+chunkBase (Element e) {
+    return e - (Element) ((unsigned long) e & (SET_CHUNK_BITS - 1));
+}
+
+/**
+ * Liefert die Position des niedrigsten gesetzten Bits.
+ *
+ * @param[in] w das Wort, ungleich 0.
+ *
+ * @return Position des Bits.
+ */
+static unsigned long
+lowestBit (unsigned long w) {
+#ifdef __GNUC__
+    return (unsigned long) __builtin_ctzl(w);
+#else
+    unsigned long i = 0;
+
+    while(!(w & 1UL)){
+        w >>= 1;
+        i++;
     }
-    return curr;
+    return i;
+#endif
 }
 
-Set
-set_insert (Set s, Element e) {
-    Set curr = s;
-    Set prev = NULL;
-          
-    /* Wenn leer, dann erzeuge neues Intervall */
-    if (SET_IS_EMPTY(s)) {
-        s = createIntervall(e,e,EMPTY_SET);
-        assert(set_contains(s,e));
-        return s;
+/**
+ * Zaehlt die gesetzten Bits eines Worts.
+ *
+ * @param[in] w das Wort.
+ *
+ * @return Anzahl der gesetzten Bits.
+ */
+static unsigned long
+countBits (unsigned long w) {
+#ifdef __GNUC__
+    return (unsigned long) __builtin_popcountl(w);
+#else
+    unsigned long n = 0;
+
+    while(w != 0){
+        w &= w - 1;
+        n++;
     }
+    return n;
+#endif
+}
 
-    /* Travasieren */
-    while(curr != EMPTY_SET && e > curr->end){
-        prev = curr;
-        curr = curr->next;
+/**
+ * Setzt die Bits aller Elemente von start bis end in der Bitmap eines Blocks.
+ *
+ * @param[in,out] bits  die Bitmap.
+ * @param[in]     base  erstes Element des Blocks.
+ * @param[in]     start der Anfang des Intervalls.
+ * @param[in]     end   das Ende des Intervalls.
+ *
+ * @pre base <= start <= end < base + SET_CHUNK_BITS
+ */
+static void
+setBits (unsigned long * bits, Element base, Element start, Element end) {
+    unsigned long from = (unsigned long) (start - base);
+    unsigned long to = (unsigned long) (end - base);
+    unsigned long w = from / WORD_BITS;
+    unsigned long last = to / WORD_BITS;
+    unsigned long low = ~0UL << (from % WORD_BITS);
+    unsigned long high = ~0UL >> (WORD_BITS - 1 - to % WORD_BITS);
+
+    if (w == last) {
+        bits[w] |= low & high;
+        return;
     }
+    bits[w++] |= low;
+    while(w < last){
+        bits[w++] = ~0UL;
+    }
+    bits[last] |= high;
+}
 
-    /* Wenn wir ganz hinten sind, hinten einfuegen **/
-    if (curr == NULL) {
-        if (e == prev->end + 1) {
-            prev->end = e;
-        }
-        else{
-        prev->next = createIntervall(e,e,EMPTY_SET);
+/**
+ * Prueft, ob ein Knoten das Element e enthaelt.
+ *
+ * @param[in] node der Knoten.
+ * @param[in] e    das Element.
+ *
+ * @return 1, falls Element enthalten ist, sonst 0.
+ */
+static int
+nodeContains (Set node, Element e) {
+    unsigned long off = 0;
+    unsigned int i = 0;
+
+    if (e < NODE_FIRST(node) || e > NODE_LAST(node)) {
+        return 0;
+    }
+    if (node->bits == NULL) {
+        while(node->ends[i] < e){
+            i++;
         }
-        assert(set_contains(s,e));
-        return s;
+        return node->starts[i] <= e;
     }
-    /* Wenn wir nicht vorne sind, fuege richtig ein */
-    if(!SET_IS_EMPTY(prev)){
-        if (e >= curr->start) {
-            /* Element bereits drinnen */
-            assert(set_contains(s,e));
-            return s;
+    off = (unsigned long) (e - chunkBase(NODE_FIRST(node)));
+    return (node->bits[off / WORD_BITS] >> (off % WORD_BITS)) & 1UL;
+}
+
+/**
+ * Liefert das naechste Intervall innerhalb des aktuellen Knotens eines Cursors
+ * und setzt den Cursor dahinter.
+ *
+ * @param[in,out] c     der Cursor.
+ * @param[out]    start Anfang des Intervalls.
+ * @param[out]    end   Ende des Intervalls.
+ *
+ * @pre c->node ist nicht c->stop.
+ */
+static void
+nodeRun (SetListCursor * c, Element * start, Element * end) {
+    Set node = c->node;
+    Element base = 0;
+    unsigned long off = 0, w = 0, word = 0, first = 0, last = 0;
+    unsigned int i = 0;
+
+    if (node->bits == NULL) {
+        while(node->ends[i] < c->pos){
+            i++;
         }
-        if (e == curr->start - 1) {
-            curr->start = e;
+        *start = node->starts[i] > c->pos ? node->starts[i] : c->pos;
+        *end = node->ends[i];
+    } else {
+        /* erstes gesetztes Bit ab pos, danach erstes geloeschtes Bit */
+        base = chunkBase(NODE_FIRST(node));
+        off = (unsigned long) (c->pos - base);
+        w = off / WORD_BITS;
+        word = node->bits[w] & (~0UL << (off % WORD_BITS));
+        while(word == 0){
+            word = node->bits[++w];
         }
-        if (e == prev->end + 1) {
-            prev->end = e;
+        first = w * WORD_BITS + lowestBit(word);
+
+        word = ~node->bits[w] & (~0UL << (first % WORD_BITS));
+        while(word == 0 && w + 1 < CHUNK_WORDS){
+            word = ~node->bits[++w];
         }
-        if (prev->end == curr->start) {
-            prev->next = curr->next;
-            prev->end = curr->end;
-            free(curr);
-            setlist_refs--;
-            assert(set_contains(s,e));
-            return s;
+        last = word == 0 ? SET_CHUNK_BITS - 1 : w * WORD_BITS + lowestBit(word) - 1;
+
+        *start = base + (Element) first;
+        *end = base + (Element) last;
+    }
+
+    if (*end == NODE_LAST(node)) {
+        c->node = node->next;
+        if (c->node != c->stop) {
+            c->pos = NODE_FIRST(c->node);
         }
-        else if((e == prev->end  )|| (e == curr->start )){
-            assert(set_contains(s,e));
-            return s;
+    } else {
+        c->pos = *end + 1;
+    }
+}
+
+/**
+ * Initialisiert einen Cursor, der die Knoten ab from bis ausschliesslich stop liest.
+ *
+ * @param[out] c    der Cursor.
+ * @param[in]  from erster zu lesender Knoten.
+ * @param[in]  stop Knoten, an dem das Lesen endet.
+ */
+static void
+cursorInit (SetListCursor * c, Set from, Set stop) {
+    c->node = from;
+    c->stop = stop;
+    c->pos = from != stop ? NODE_FIRST(from) : 0;
+}
+
+/**
+ * Sorgt dafuer, dass alle Knoten vor dem Knoten stop ausschliesslich zu dieser
+ * Liste gehoeren. Geteilte Knoten werden dazu durch Kopien ersetzt (Pfadkopie),
+ * die Nachfolger der Kopien werden weiterhin geteilt.
+ *
+ * @param[in,out] head der Listenanfang.
+ * @param[in]     stop ein Knoten der Liste oder EMPTY_SET.
+ *
+ * @return der nun exklusive Verweis auf den Knoten stop.
+ */
+static Set *
+ownLinkTo (Set * head, Set stop) {
+    Set * link = head;
+
+    while(*link != stop){
+        Set node = *link;
+
+        if (node->refs > 1) {
+            *link = createIntervall(0, 0, EMPTY_SET);
+            memcpy(*link, node, sizeof(struct Intervall));
+            (*link)->refs = 1;
+            if (node->bits != NULL) {
+                (*link)->bits = allocate(&stats, CHUNK_BYTES, 0);
+                memcpy((*link)->bits, node->bits, CHUNK_BYTES);
+                stats.liveBitmaps++;
+            }
+            if (!SET_IS_EMPTY(node->next)) {
+                node->next->refs++;
+            }
+            node->refs--;
         }
+        link = &(*link)->next;
     }
-    /* Wenn wir vorne sind, fuege richtig ein */
-    else{
-        if(e >= curr->start){
-            assert(set_contains(s,e));
-            return s;
-        }
-        else if (e == curr->start - 1) {
-            curr->start = e;
-            assert(set_contains(s,e));
-            return s;
-        } 
-        else {
-            Set new = createIntervall(e,e,EMPTY_SET);
-            new->next = s;
-            assert(set_contains(new,e));
-            return new; 
-        } 
-    }
-    prev->next = createIntervall(e,e,EMPTY_SET);
-    prev->next->next = curr;
-    assert(set_contains(s,e));
-    return s;   
+
+    return link;
 }
 
+/**
+ * Zustand einer Quelle, die genau ein Intervall liefert.
+ */
+typedef struct {
+    Element start;
+    Element end;
+    int done;
+} RangeState;
 
-Set
-set_remove (Set s, long e) {
-    Set curr = s;
-    Set prev = EMPTY_SET;
+/**
+ * Liefert das Intervall einer Intervall-Quelle.
+ *
+ * @param[in,out] state der Zustand (RangeState).
+ * @param[out]    start Anfang des Intervalls.
+ * @param[out]    end   Ende des Intervalls.
+ *
+ * @return 1, falls das Intervall geliefert wurde, 0 wenn die Quelle erschoepft ist.
+ */
+static int
+rangeSourceNext (void * state, Element * start, Element * end) {
+    RangeState * range = state;
 
-    /**travasieren**/
-    while(curr != EMPTY_SET && e > curr->end  ){
-        prev = curr;
-        curr = curr->next;
+    if (range->done) {
+        return 0;
     }
+    range->done = 1;
+    *start = range->start;
+    *end = range->end;
+    return 1;
+}
 
-    /* pruefe nachfolgend alle faelle */
-    if (SET_IS_EMPTY(curr)) {
-        assert(!set_contains(s,e));
-        return s;
+static int listSourceNext (void * state, Element * start, Element * end);
+static void builderFlush (SetBuilder * b);
+
+/**
+ * Verknuepft die Menge s mit dem Bereich [start, end] gemaess op (Vereinigung
+ * oder Differenz).
+ *
+ * Alle Knoten der Bloecke von start bis end sowie direkt angrenzende Knoten
+ * werden gelesen, verknuepft, mit dem Builder neu aufgebaut und durch die neuen
+ * Knoten ersetzt. Dabei wird fuer jeden betroffenen Block neu entschieden, ob er
+ * als Intervalle oder als Bitmap gespeichert wird, und die Intervalle werden
+ * dicht in Knoten gepackt. Ein nicht voller Intervallknoten direkt davor wird
+ * mit neu aufgebaut, so dass Knoten beim Entfernen wieder verschmolzen werden.
+ * Geteilte Knoten vor den ersetzten Knoten werden kopiert, die ersetzten Knoten
+ * nur freigegeben.
+ *
+ * @param[in,out] s     die Menge.
+ * @param[in]     start der Anfang des Bereichs.
+ * @param[in]     end   das Ende des Bereichs.
+ * @param[in]     op    SET_OP_UNION oder SET_OP_DIFFERENCE.
+ *
+ * @return die veraenderte Menge.
+ */
+static Set
+editRange (Set s, Element start, Element end, SetOp op) {
+    Element low = chunkBase(start);
+    Element high = chunkBase(end) + (SET_CHUNK_BITS - 1);
+    Set first = s;
+    Set prev = EMPTY_SET;
+    Set after = EMPTY_SET;
+    Set curr = EMPTY_SET;
+    Set tail = EMPTY_SET;
+    Set * link = NULL;
+    unsigned int i = 0;
+    int changed = 0;
+    SetStatsOp outer = SET_STATS_BUILD;
+    SetListCursor cursor;
+    RangeState range;
+    SetBuilder builder;
+    SetSource srcA, srcB;
+    SetSink sink;
+
+    /* betroffen sind alle Knoten, die die Bloecke von start bis end
+     * beruehren oder direkt an sie angrenzen */
+    while(!SET_IS_EMPTY(first) && NODE_LAST(first) < low && NODE_LAST(first) + 1 < low){
+        prev = first;
+        first = first->next;
     }
-    
-    else if (e == curr->end && e != curr->start) {
-        curr->end = curr->end-1;
-        assert(!set_contains(s,e));
-        return s;
+    after = first;
+    while(!SET_IS_EMPTY(after) && (NODE_FIRST(after) <= high || NODE_FIRST(after) - 1 == high)){
+        after = after->next;
     }
-    else if (e == curr->start && e != curr->end) {
-        curr->start = curr->start+1;
-        assert(!set_contains(s,e));
-        return s;
+
+    /* Pruefen, ob die Aenderung ueberhaupt etwas bewirkt */
+    for(curr = first; curr != after; curr = curr->next){
+        for(i = 0; i < curr->count; i++){
+            if (op == SET_OP_UNION) {
+                if (curr->bits == NULL && curr->starts[i] <= start && end <= curr->ends[i]) {
+                    return s;
+                }
+            } else {
+                changed = changed || (curr->starts[i] <= end && curr->ends[i] >= start);
+            }
+        }
     }
-    else if (e > curr->start && e < curr->end) {
-        curr->next = createIntervall(e+1, curr->end, curr->next);
-        curr->end = e-1;
-        assert(!set_contains(s,e));
+    if (op != SET_OP_UNION && !changed) {
         return s;
     }
-    else if (prev == EMPTY_SET){
-        s = s->next;
-        free(curr);
-        setlist_refs--;  
-        assert(!set_contains(s,e));
-        return s;
+
+    if (!SET_IS_EMPTY(prev) && prev->bits == NULL && prev->count < SET_NODE_INTERVALS) {
+        first = prev;
     }
-    else{
-        prev->next = curr->next;
-        free(curr);
-        setlist_refs--; 
-        assert(!set_contains(s,e));
-        return s;
+
+    outer = statsEnter(op == SET_OP_UNION ? SET_STATS_INSERT : SET_STATS_REMOVE);
+
+    link = ownLinkTo(&s, first);
+
+    cursorInit(&cursor, first, after);
+    srcA.next = listSourceNext;
+    srcA.seek = NULL;
+    srcA.state = &cursor;
+    range.start = start;
+    range.end = end;
+    range.done = 0;
+    srcB.next = rangeSourceNext;
+    srcB.seek = NULL;
+    srcB.state = &range;
+    set_builder_init(&builder);
+    sink = set_sink_builder(&builder);
+    set_merge(&srcA, &srcB, op, &sink);
+    builderFlush(&builder);
+    tail = builder.tail;
+    curr = set_builder_finish(&builder);
+
+    /* neue Knoten einhaengen und die ersetzten freigeben */
+    if (SET_IS_EMPTY(curr)) {
+        *link = after;
+    } else {
+        tail->next = after;
+        *link = curr;
+    }
+    if (first != after) {
+        if (!SET_IS_EMPTY(after)) {
+            after->refs++;
+        }
+        releaseList(first);
     }
+    statsLeave(outer);
+
+    return s;
+}
+
+Set
+set_insert (Set s, Element e) {
+    s = set_insert_range(s, e, e);
+    assert(set_contains(s,e));
+    return s;
+}
+
+
+Set
+set_remove (Set s, long e) {
+    s = set_remove_range(s, e, e);
+    assert(!set_contains(s,e));
+    return s;
+}
+
+
+Set
+set_insert_range (Set s, Element start, Element end) {
+    assert(start <= end);
+
+    return editRange(s, start, end, SET_OP_UNION);
+}
+
+
+Set
+set_remove_range (Set s, Element start, Element end) {
+    assert(start <= end);
+
+    return editRange(s, start, end, SET_OP_DIFFERENCE);
 }
 
 
 Set
 set_clear (Set s) {
     
-    while(!SET_IS_EMPTY(s)){
-        Set toFree = s;
-        s = s->next;
-        free(toFree);
-        setlist_refs--;
-    }
+    /* Knoten nur freigeben, solange sie nicht noch von einer Kopie
+     * verwendet werden */
+    releaseList(s);
+    s = EMPTY_SET;
     assert(SET_IS_EMPTY(s));
     return s;
     
 }
 
+/**
+ * Liefert die Anzahl der Elemente eines Knotens.
+ *
+ * @param[in] node der Knoten.
+ *
+ * @return Anzahl der Elemente.
+ */
+static unsigned long
+nodeCardinality (Set node) {
+    unsigned long counter = 0;
+    unsigned long w = 0;
+
+    if (node->bits == NULL) {
+        for(w = 0; w < node->count; w++){
+            counter = counter + (node->ends[w]+1 - node->starts[w]);
+        }
+        return counter;
+    }
+    for(w = 0; w < CHUNK_WORDS; w++){
+        counter = counter + countBits(node->bits[w]);
+    }
+    return counter;
+}
+
 unsigned long
 set_cardinality (Set s) {
     unsigned long counter = 0;
     Set curr = s;
 
     while(!SET_IS_EMPTY(curr)){
-        counter = counter + (curr->end+1 - curr->start);
+        counter = counter + nodeCardinality(curr);
         curr = curr->next;
     }
 
@@ -248,14 +677,14 @@ set_max(Set s) {
         curr = curr->next;
     }
     
-    return curr->end;
+    return NODE_LAST(curr);
 }
 
 Element
 set_min(Set s) {
     assert(!SET_IS_EMPTY(s));
 
-    return s->start;
+    return NODE_FIRST(s);
 }
 
 
@@ -265,8 +694,8 @@ set_contains (Set s, long e) {
     if(SET_IS_EMPTY(s)){
         return 0;
     }
-    while(!SET_IS_EMPTY(s)){
-        if (e >= s->start && e <= s->end) {
+    while(!SET_IS_EMPTY(s) && NODE_FIRST(s) <= e){
+        if (nodeContains(s, e)) {
             return 1;
         }
         s = s->next;
@@ -275,667 +704,820 @@ set_contains (Set s, long e) {
 }
 
 
-int
-set_is_subset (Set a, Set b) {
+/**
+ * Eine Anfrage an set_contains_many mit ihrer urspruenglichen Position.
+ */
+typedef struct {
+    Element value;
+    unsigned long pos;
+} Query;
 
-if (SET_IS_EMPTY(a)){
-    return 1;
-} else if (SET_IS_EMPTY(b)) {
-    return 0;
-}
+/**
+ * Vergleicht zwei Anfragen nach ihrem Wert (fuer qsort).
+ *
+ * @param[in] a erste Anfrage.
+ * @param[in] b zweite Anfrage.
+ *
+ * @return negativ, 0 oder positiv, wenn a kleiner, gleich oder groesser b ist.
+ */
+static int
+compareQueries (const void * a, const void * b) {
+    Element x = ((const Query *) a)->value;
+    Element y = ((const Query *) b)->value;
 
-/**iteration durch die liste**/
-while(!SET_IS_EMPTY(a) && !SET_IS_EMPTY(b)){
-    if (a->start >= b->start && a->end <= b->end){
-        a = a->next;
-    } else if(a->start > b->end){
-        b = b->next;
-    } else {
-        return 0;
-    }
+    return (x > y) - (x < y);
 }
 
-if(SET_IS_EMPTY(a)){
-    return 1;
-} else {
-    return 0;
-}
-}
 
+void
+set_contains_many (Set s, const Element queries[], unsigned long n, int results[]) {
+    SetCursor cursor;
+    Query * sorted = NULL;
+    unsigned long i = 0;
 
-int
-set_equals (Set a, Set b) {
+    assert(n == 0 || (queries != NULL && results != NULL));
 
-    if(SET_IS_EMPTY(a) && SET_IS_EMPTY(b)){
-        return 1;
-    } else if((SET_IS_EMPTY(a) && !SET_IS_EMPTY(b)) || (!SET_IS_EMPTY(a) && SET_IS_EMPTY(b))){
-        return 0;
+    set_cursor_init(&cursor, s);
+
+    /* bereits sortierte Anfragen direkt in einem Durchlauf beantworten */
+    while(i + 1 < n && queries[i] <= queries[i + 1]){
+        i++;
     }
-    /* ueberprueft ob der Start und das Ende des Intervalls uebereinstimmt */
-    while(!SET_IS_EMPTY(a)){
-        if((a->start != b->start) || (a->end != b->end)){
-            return 0;
+    if (i + 1 >= n) {
+        for(i = 0; i < n; i++){
+            results[i] = set_cursor_contains(&cursor, queries[i]);
         }
-        a = a->next;
-        b = b->next;
+        return;
     }
 
-    if(SET_IS_EMPTY(a) && SET_IS_EMPTY(b)){
-        return 1;
+    sorted = malloc(n * sizeof(Query));
+    if (sorted == NULL) {
+        exit(ERR_OUT_OF_MEMORY);
+    }
+    for(i = 0; i < n; i++){
+        sorted[i].value = queries[i];
+        sorted[i].pos = i;
     }
+    qsort(sorted, n, sizeof(Query), compareQueries);
 
-    return 0;
+    for(i = 0; i < n; i++){
+        results[sorted[i].pos] = set_cursor_contains(&cursor, sorted[i].value);
+    }
+    free(sorted);
 }
 
- 
 
-Set
-set_union (Set a, Set b) {
-    int biggestNum = 0;
-    Set new = EMPTY_SET;
-    Set curr = new;
+void
+set_cursor_init (SetCursor * c, Set s) {
+    assert(c != NULL);
 
-/**hauptalgorithmus**/
-while(!SET_IS_EMPTY(a) || !SET_IS_EMPTY(b)){
-    /**fuer den fall das a groesser als b ist**/
-    if (SET_IS_EMPTY(b) || (!SET_IS_EMPTY(a) && a->start <= b->start)) {
-        if(SET_IS_EMPTY(new)){
-            new = createIntervall(a->start, a->end,NULL);
-            curr = new;
-            biggestNum = a->end;
-            a = a->next; 
-        }
-        else if(a->start <= biggestNum && a->end > biggestNum){
-            curr->end = a->end;
+    c->head = s;
+    c->pos = s;
+    c->floor = LONG_MIN;
+}
 
-            biggestNum = a->end;
-            a = a->next; 
-        }
-        else if(a->start <= biggestNum){
-            a = a->next; 
-        }
 
-        else if(a->start == curr->end + 1){
-            curr->end = a->end;
-            a = a->next; 
-        }
-        else if(a->start > curr->end){
-            curr->next = createIntervall(a->start, a->end,NULL);
-            curr= curr->next;
-            biggestNum = a->end;
-            a = a->next; 
-        }
-        else {
-            a = a->next; 
-        }
+int
+set_cursor_contains (SetCursor * c, Element e) {
+    assert(c != NULL);
+
+    /* rueckwaerts geht es nur vom Listenanfang aus */
+    if (e < c->floor) {
+        c->pos = c->head;
     }
-    /**fuer  den fall das b groesser ist**/
-    else if(!SET_IS_EMPTY(b)){
-        if(SET_IS_EMPTY(new)){
-            new = createIntervall(b->start, b->end,NULL);
-            curr = new;
-            biggestNum = b->end;
-            b= b->next; 
-        }
-        else if(b->start <= biggestNum && b->end > biggestNum){
-            curr->end = b->end;
+    c->floor = e;
 
-            biggestNum = b->end;
-            b = b->next; 
-        }
-        else if(b->start <= biggestNum){
-            b = b->next; 
+    while(!SET_IS_EMPTY(c->pos) && NODE_LAST(c->pos) < e){
+        c->pos = c->pos->next;
+    }
+
+    return !SET_IS_EMPTY(c->pos) && nodeContains(c->pos, e);
+}
+
+
+int
+set_is_subset (Set a, Set b) {
+    SetListCursor ca, cb;
+    Element as = 0, ae = 0, bs = 0, be = 0;
+    int haveB = 0;
+
+    cursorInit(&ca, a, EMPTY_SET);
+    cursorInit(&cb, b, EMPTY_SET);
+
+    /* Iteration durch die Intervalle, ab einer gemeinsamen Leseposition
+     * sind beide gleich */
+    while(listSourceNext(&ca, &as, &ae)){
+        while(haveB == 0 || be < as){
+            if (!listSourceNext(&cb, &bs, &be)) {
+                return 0;
+            }
+            haveB = 1;
         }
-        else if(b->start == curr->end + 1){
-            curr->end = b->end;
-            b = b->next; 
+        if (as < bs || ae > be) {
+            return 0;
         }
-        else if(b->start > curr->end){
-            curr->next = createIntervall(b->start, b->end,NULL);
-            curr= curr->next;
-            biggestNum = b->end;
-            b = b->next; 
+        if (ca.node == cb.node && (SET_IS_EMPTY(ca.node) || ca.pos == cb.pos)) {
+            return 1;
         }
-        else {
-            b = b->next; 
+    }
+
+    return 1;
+}
+
+
+int
+set_equals (Set a, Set b) {
+    SetListCursor ca, cb;
+    Element as = 0, ae = 0, bs = 0, be = 0;
+    int haveA = 0, haveB = 0;
+
+    cursorInit(&ca, a, EMPTY_SET);
+    cursorInit(&cb, b, EMPTY_SET);
+
+    /* ueberprueft ob der Start und das Ende der Intervalle uebereinstimmen,
+     * ab einer gemeinsamen Leseposition sind die Listen identisch */
+    while(ca.node != cb.node || (!SET_IS_EMPTY(ca.node) && ca.pos != cb.pos)){
+        haveA = listSourceNext(&ca, &as, &ae);
+        haveB = listSourceNext(&cb, &bs, &be);
+        if (haveA != haveB || as != bs || ae != be) {
+            return 0;
         }
+    }
+
+    return 1;
+}
+
+ 
+
+/**
+ * Liefert das naechste Intervall einer Listen-Quelle. Direkt aneinander
+ * angrenzende Intervalle aufeinander folgender Knoten werden zusammengefasst.
+ *
+ * @param[in,out] state die Leseposition (SetListCursor).
+ * @param[out]    start Anfang des Intervalls.
+ * @param[out]    end   Ende des Intervalls.
+ *
+ * @return 1, falls ein Intervall geliefert wurde, 0 wenn die Liste erschoepft ist.
+ */
+static int
+listSourceNext (void * state, Element * start, Element * end) {
+    SetListCursor * c = state;
+    Element s = 0;
 
+    if (c->node == c->stop) {
+        return 0;
+    }
+    nodeRun(c, start, end);
+    while(c->node != c->stop && *end != LONG_MAX && NODE_FIRST(c->node) == *end + 1 && c->pos == NODE_FIRST(c->node)){
+        nodeRun(c, &s, end);
     }
+    return 1;
 }
-    return new;
+
+/**
+ * Ueberspringt alle Intervalle einer Listen-Quelle, die vor dem Element e enden,
+ * und liefert das erste verbleibende Intervall. Dessen Anfang kann dabei
+ * abgeschnitten sein, wenn es an einen uebersprungenen Knoten angrenzt.
+ *
+ * @param[in,out] state die Leseposition (SetListCursor).
+ * @param[in]     e     das Element.
+ * @param[out]    start Anfang des Intervalls.
+ * @param[out]    end   Ende des Intervalls.
+ *
+ * @return 1, falls ein Intervall geliefert wurde, 0 wenn die Liste erschoepft ist.
+ */
+static int
+listSourceSeek (void * state, Element e, Element * start, Element * end) {
+    SetListCursor * c = state;
+    int have = 0;
+
+    /* ganze Knoten ueberspringen */
+    if (c->node != c->stop && NODE_LAST(c->node) < e) {
+        do {
+            c->node = c->node->next;
+        } while(c->node != c->stop && NODE_LAST(c->node) < e);
+        if (c->node != c->stop) {
+            c->pos = NODE_FIRST(c->node);
+        }
+    }
+    do {
+        have = listSourceNext(state, start, end);
+    } while(have && *end < e);
+
+    return have;
 }
 
+/**
+ * Haengt ein Intervall an den Builder einer Builder-Senke an.
+ *
+ * @param[in,out] state Zeiger auf den Builder.
+ * @param[in]     start Anfang des Intervalls.
+ * @param[in]     end   Ende des Intervalls.
+ */
+static void
+builderSinkEmit (void * state, Element start, Element end) {
+    set_builder_append_range(state, start, end);
+}
 
+/**
+ * Holt das erste Intervall einer Quelle, dessen Ende nicht vor e liegt.
+ * Quellen ohne eigene Sprungfunktion werden dazu intervallweise durchlaufen.
+ *
+ * @param[in,out] src   die Quelle.
+ * @param[in]     e     das Element.
+ * @param[out]    start Anfang des Intervalls.
+ * @param[out]    end   Ende des Intervalls.
+ *
+ * @return 1, falls ein Intervall geliefert wurde, 0 wenn die Quelle erschoepft ist.
+ */
+static int
+sourceSeek (SetSource * src, Element e, Element * start, Element * end) {
+    int have = 0;
+
+    if (src->seek != NULL) {
+        return src->seek(src->state, e, start, end);
+    }
+    do {
+        have = src->next(src->state, start, end);
+    } while(have && *end < e);
+
+    return have;
+}
 
-Set
-set_intersection (Set a, Set b) {
 
-    Set new = EMPTY_SET;
-    Set curr = new;
-    long tempValue = 0;
+SetSource
+set_source_list (SetListCursor * cursor, Set s) {
+    SetSource src;
 
-if(SET_IS_EMPTY(a) || SET_IS_EMPTY(b)){
-    return new;
+    assert(cursor != NULL);
+
+    cursorInit(cursor, s, EMPTY_SET);
+    src.next = listSourceNext;
+    src.seek = listSourceSeek;
+    src.state = cursor;
+    return src;
 }
 
-tempValue = a->start;
 
-while(!SET_IS_EMPTY(a) && !SET_IS_EMPTY(b)){
-    if (tempValue <= b->start) {
-        if(a->end < b->start){
-            a = a->next; 
-            if(!SET_IS_EMPTY(a)){
-                tempValue = a->start;
-            }
-            /** Hier wird nur das letzte Element hinzu gefuegt */
-        } else if (a->end == b->start){
-            if(SET_IS_EMPTY(new)){
-                new = createIntervall(a->end, a->end,NULL);
-                curr = new;
-                a = a->next;
-            } else {
-                curr->next = createIntervall(a->end, a->end,NULL);
-                curr= curr->next;
-                a = a->next; 
-            }
-            if(!SET_IS_EMPTY(a)){
-                tempValue = a->start;
-            }
-            /** Hier wird die das Intervall von b hinzugefuegt */
-        } else if(a->end > b->end){
-            if(SET_IS_EMPTY(new)){
-                new = createIntervall(b->start, b->end,NULL);
-                curr = new;
-                tempValue = b->end+1;
-                b = b->next;
-            } else {
-                curr->next = createIntervall(b->start, b->end,NULL);
-                curr= curr->next;
-                tempValue = b->end+1;
-                b = b->next; 
-            }
-            /** Hier werden beide am ende weiter gesetzt */
-        } else if(a->end == b->end) {
-            if(SET_IS_EMPTY(new)){
-                new = createIntervall(b->start, a->end,NULL);
-                curr = new;
-            } else {
-                curr->next = createIntervall(b->start, a->end,NULL);
-                curr= curr->next;
-            }
-            b = b->next;
-            a = a->next;
-            if(!SET_IS_EMPTY(a)){
-                tempValue = a->start;
-            }
-            /** die difference hinzufuegen */
-        } else {
-            if(SET_IS_EMPTY(new)){
-                new = createIntervall(b->start, a->end,NULL);
-                curr = new;
-                a = a->next;
+SetSink
+set_sink_builder (SetBuilder * b) {
+    SetSink sink;
+
+    assert(b != NULL);
+
+    sink.emit = builderSinkEmit;
+    sink.state = b;
+    return sink;
+}
+
+
+void
+set_merge (SetSource * a, SetSource * b, SetOp op, SetSink * out) {
+    Element as = 0, ae = 0, bs = 0, be = 0;
+    Element x = 0, lastA = 0, lastB = 0, segEnd = 0;
+    Element ps = 0, pe = 0;
+    int haveA = 0, haveB = 0, inA = 0, inB = 0, pending = 0;
+    /* Beitrag, wenn nur a bzw. nur b das aktuelle Stueck enthaelt */
+    int onlyA = (op >> 2) & 1;
+    int onlyB = (op >> 1) & 1;
+
+    assert(a != NULL && b != NULL && out != NULL);
+    assert((op & 1) == 0);
+
+    haveA = a->next(a->state, &as, &ae);
+    haveB = b->next(b->state, &bs, &be);
+    if (haveA && haveB) {
+        x = as < bs ? as : bs;
+    } else {
+        x = haveA ? as : bs;
+    }
+
+    /* Invariante: ein vorhandenes aktuelles Intervall endet nie vor x */
+    while((haveA && (haveB || onlyA)) || (haveB && onlyB)){
+        /* Liegt x ausserhalb von a und traegt b allein nichts bei, sind alle
+         * Intervalle von b vor dem naechsten Anfang von a bedeutungslos
+         * (und umgekehrt), also galoppierend ueberspringen */
+        if (!onlyB && haveB && as > x && be < as) {
+            haveB = sourceSeek(b, as, &bs, &be);
+            continue;
+        }
+        if (!onlyA && haveA && bs > x && ae < bs) {
+            haveA = sourceSeek(a, bs, &as, &ae);
+            continue;
+        }
+
+        /* Zustand an Position x und das Ende des Stuecks, in dem er sich
+         * nicht aendert */
+        inA = haveA && as <= x;
+        inB = haveB && bs <= x;
+        lastA = !haveA ? LONG_MAX : (inA ? ae : as - 1);
+        lastB = !haveB ? LONG_MAX : (inB ? be : bs - 1);
+        segEnd = lastA < lastB ? lastA : lastB;
+
+        if ((op >> ((inA << 1) | inB)) & 1) {
+            if (pending && pe + 1 == x) {
+                pe = segEnd;
             } else {
-                curr->next = createIntervall(b->start, a->end,NULL);
-                curr= curr->next;
-                a = a->next; 
-            }
-            if(!SET_IS_EMPTY(a)){
-                tempValue = a->start;
+                if (pending) {
+                    out->emit(out->state, ps, pe);
+                }
+                ps = x;
+                pe = segEnd;
+                pending = 1;
             }
         }
-        /** Hier wird die Liste b bearbeitet */
-    } else if(b->end < tempValue){
-            b = b->next;
-    } else if(b->end == tempValue){
-        if(SET_IS_EMPTY(new)){
-            new = createIntervall(b->end, b->end,NULL);
-            curr = new;
-            tempValue = b->end+1;
-            b = b->next;
-        } else {
-            curr->next = createIntervall(b->end, b->end,NULL);
-            curr= curr->next;
-            tempValue = b->end+1;
-            b = b->next;
-        }
-        /** von dem temporaeren Wert bis zum ende des Intervalls von b */
-    } else if(b->end < a->end){
-        if(SET_IS_EMPTY(new)){
-            new = createIntervall(tempValue, b->end,NULL);
-            curr = new;
-            tempValue = b->end+1;
-            b = b->next;
-        } else {
-            curr->next = createIntervall(tempValue, b->end,NULL);
-            curr= curr->next;
-            tempValue = b->end+1;
-            b = b->next;
-        }
-    } else if(b->end == a->end) {
-        if(SET_IS_EMPTY(new)){
-            new = createIntervall(tempValue, b->end,NULL);
-            curr = new;
-        } else {
-            curr->next = createIntervall(tempValue, b->end,NULL);
-            curr= curr->next;
+
+        if (segEnd == LONG_MAX) {
+            break;
         }
-        b = b->next;
-        a = a->next;
-        if(!SET_IS_EMPTY(a)){
-            tempValue = a->start;
+        x = segEnd + 1;
+        if (haveA && ae < x) {
+            haveA = a->next(a->state, &as, &ae);
         }
-        /** Falls das Ende von b groesser sein sollte */
-    } else {
-       if(SET_IS_EMPTY(new)){
-            new = createIntervall(tempValue, a->end,NULL);
-            curr = new;
-        } else {
-            curr->next = createIntervall(tempValue, a->end,NULL);
-            curr= curr->next;
+        if (haveB && be < x) {
+            haveB = b->next(b->state, &bs, &be);
         }
-        a = a->next;
-        if(!SET_IS_EMPTY(a)){
-            tempValue = a->start;
-        } 
     }
-}
-return new;
-}
-
 
+    if (pending) {
+        out->emit(out->state, ps, pe);
+    }
+}
 
 
-Set
-set_difference (Set a, Set b) {
-
-    Set new = EMPTY_SET;
-    Set curr = new;
-    long tempValue = 0;
+/**
+ * Aktuelles Intervall einer Quelle in set_merge_all.
+ */
+typedef struct {
+    /** das Intervall */
+    Element start;
+    Element end;
+    /** die Quelle */
+    SetSource * src;
+} MergeEntry;
 
-if(!SET_IS_EMPTY(a) && SET_IS_EMPTY(b)){
-    while(!SET_IS_EMPTY(a)){
-        if(SET_IS_EMPTY(new)){
-                new = createIntervall(a->start, a->end,NULL);
-                curr = new;
-                a = a->next;
-            } else {
-                curr->next = createIntervall(a->start, a->end,NULL);
-                curr= curr->next;
-                a = a->next;
+/**
+ * Laesst einen Eintrag im Heap von set_merge_all nach unten sinken, bis kein
+ * Kind einen kleineren Schluessel hat.
+ *
+ * @param[in,out] heap  der Heap.
+ * @param[in]     size  Anzahl der Eintraege.
+ * @param[in]     i     Position des Eintrags.
+ * @param[in]     byEnd 1, falls nach dem Ende geordnet wird, 0 nach dem Anfang.
+ */
+static void
+heapSiftDown (MergeEntry * heap, unsigned long size, unsigned long i, int byEnd) {
+    MergeEntry entry = heap[i];
+    Element key = byEnd ? entry.end : entry.start;
+    Element childKey = 0, otherKey = 0;
+    unsigned long child = 0;
+
+    while((child = 2 * i + 1) < size){
+        childKey = byEnd ? heap[child].end : heap[child].start;
+        if (child + 1 < size) {
+            otherKey = byEnd ? heap[child + 1].end : heap[child + 1].start;
+            if (otherKey < childKey) {
+                child++;
+                childKey = otherKey;
             }
+        }
+        if (key <= childKey) {
+            break;
+        }
+        heap[i] = heap[child];
+        i = child;
     }
-    return new;
+    heap[i] = entry;
 }
 
-/** Sollte keine von beiden Leer sein wird fortgesetzt */
-
-if(!SET_IS_EMPTY(a)){
-    tempValue = a->start;
+/**
+ * Gibt ein Ergebnisintervall an die Senke weiter. Ueberschneidet es das
+ * zurueckgehaltene Intervall oder grenzt daran an, werden beide zusammengefasst,
+ * sonst wird das zurueckgehaltene Intervall ausgegeben und ersetzt.
+ *
+ * @param[in,out] out     die Senke.
+ * @param[in,out] pending 1, falls ein Intervall zurueckgehalten wird.
+ * @param[in,out] ps      Anfang des zurueckgehaltenen Intervalls.
+ * @param[in,out] pe      Ende des zurueckgehaltenen Intervalls.
+ * @param[in]     start   Anfang des neuen Intervalls (nicht kleiner als *ps).
+ * @param[in]     end     Ende des neuen Intervalls.
+ */
+static void
+mergeEmit (SetSink * out, int * pending, Element * ps, Element * pe, Element start, Element end) {
+    if (*pending && (start <= *pe || start - 1 == *pe)) {
+        if (end > *pe) {
+            *pe = end;
+        }
+        return;
+    }
+    if (*pending) {
+        out->emit(out->state, *ps, *pe);
+    }
+    *ps = start;
+    *pe = end;
+    *pending = 1;
 }
 
-while(!SET_IS_EMPTY(a) && !SET_IS_EMPTY(b)){
-    if (tempValue < b->start) {
-        if(a->end < b->start){
-            if(SET_IS_EMPTY(new)){
-                new = createIntervall(tempValue, a->end,NULL);
-                curr = new;
-                a = a->next;
-            } else {
-                curr->next = createIntervall(tempValue, a->end,NULL);
-                curr= curr->next;
-                a = a->next;
-            }
-            if(!SET_IS_EMPTY(a)){
-                tempValue = a->start;
-            }
-            /** Im Falle dass das Ende von a groesser ist */
-        } else if (a->end > b->end){
-            if(SET_IS_EMPTY(new)){
-                new = createIntervall(tempValue, b->start-1,NULL);
-                curr = new;
-                tempValue = b->end + 1;
-                b = b->next;
-            } else {
-                curr->next = createIntervall(tempValue, b->start-1,NULL);
-                curr= curr->next;
-                tempValue = b->end + 1;
-                b = b->next; 
-            }
-            while(!SET_IS_EMPTY(b) && a->end > b->end){
-                curr->next = createIntervall(tempValue, b->start-1,NULL);
-                curr= curr->next;
-                tempValue = b->end + 1;
-                b = b->next; 
-            }
-            /** Hier werden beide Listen weiter gesetzt */
-        } else {
-            if(SET_IS_EMPTY(new)){
-                new = createIntervall(tempValue, b->start-1,NULL);
-                curr = new;
-            } else {
-                curr->next = createIntervall(tempValue, b->start-1,NULL);
-                curr= curr->next;
+
+void
+set_merge_all (SetSource * sources, unsigned long count, SetOp op, SetSink * out) {
+    MergeEntry * heap = NULL;
+    unsigned long size = 0, i = 0;
+    Element lo = LONG_MIN, ps = 0, pe = 0;
+    int byEnd = op == SET_OP_INTERSECTION;
+    int pending = 0, have = 0;
+
+    assert(sources != NULL || count == 0);
+    assert(out != NULL);
+    assert(op == SET_OP_UNION || op == SET_OP_INTERSECTION);
+
+    if (count == 0) {
+        return;
+    }
+    heap = malloc(count * sizeof(MergeEntry));
+    if (heap == NULL) {
+        exit(ERR_OUT_OF_MEMORY);
+    }
+
+    /* erstes Intervall jeder Quelle, eine leere Quelle leert den Schnitt */
+    for(i = 0; i < count; i++){
+        heap[size].src = &sources[i];
+        if (sources[i].next(sources[i].state, &heap[size].start, &heap[size].end)) {
+            if (heap[size].start > lo) {
+                lo = heap[size].start;
             }
-            a = a->next;
-            b = b->next;   
-            if(!SET_IS_EMPTY(a)){
-                tempValue = a->start;
+            size++;
+        } else if (byEnd) {
+            size = 0;
+            break;
+        }
+    }
+    for(i = size / 2; i > 0; i--){
+        heapSiftDown(heap, size, i - 1, byEnd);
+    }
+
+    if (!byEnd) {
+        /* Vereinigung: Intervalle aufsteigend nach ihrem Anfang entnehmen */
+        while(size > 0){
+            mergeEmit(out, &pending, &ps, &pe, heap[0].start, heap[0].end);
+            if (!heap[0].src->next(heap[0].src->state, &heap[0].start, &heap[0].end)) {
+                heap[0] = heap[--size];
             }
+            heapSiftDown(heap, size, 0, byEnd);
         }
-        /** Hier wird die Liste b bearbeitet */
     } else {
-        if(a->end <= b->end){
-            a = a->next;
-            if(!SET_IS_EMPTY(a)){
-                tempValue = a->start;
+        /* Schnitt: lo ist der groesste Anfang aller aktuellen Intervalle */
+        while(size > 0){
+            if (heap[0].end >= lo) {
+                /* jedes Intervall beginnt spaetestens bei lo und endet nicht vor heap[0].end */
+                mergeEmit(out, &pending, &ps, &pe, lo, heap[0].end);
+                if (heap[0].end == LONG_MAX) {
+                    break;
+                }
+                lo = heap[0].end + 1;
             }
-        } else {
-            tempValue = b->end+1;
-            b = b->next;
+            have = sourceSeek(heap[0].src, lo, &heap[0].start, &heap[0].end);
+            if (!have) {
+                break;
+            }
+            if (heap[0].start > lo) {
+                lo = heap[0].start;
+            }
+            heapSiftDown(heap, size, 0, byEnd);
         }
     }
-}
 
-/** Fuer den Fall das am Ende in a noch Elemente sind */
-if(SET_IS_EMPTY(b) && !SET_IS_EMPTY(a)){
-    if(a->start > tempValue){
-        tempValue = a->start;
+    if (pending) {
+        out->emit(out->state, ps, pe);
     }
-    while(!SET_IS_EMPTY(a)){
-        if(SET_IS_EMPTY(new)){
-            new = createIntervall(tempValue, a->end,NULL);
-            curr = new;
-            a = a->next;
-        } else {
-            curr->next = createIntervall(tempValue, a->end,NULL);
-            curr= curr->next;
-            a = a->next; 
-        }
-        if(!SET_IS_EMPTY(a)){
-            tempValue = a->start;
-        }
-    } 
+    free(heap);
 }
-return new;
+
+
+Set
+set_merge_build (SetSource * a, SetSource * b, SetOp op) {
+    SetBuilder builder;
+    SetSink sink = set_sink_builder(&builder);
+    SetStatsOp outer = statsEnter(SET_STATS_ALGEBRA);
+    unsigned long nodes = 0;
+    Set result = EMPTY_SET;
+
+    set_builder_init(&builder);
+    set_merge(a, b, op, &sink);
+    builderFlush(&builder);
+    nodes = builder.nodes;
+    result = set_builder_finish(&builder);
+    if (outer == SET_STATS_BUILD) {
+        stats.listLengths[statsBucket(nodes)]++;
+    }
+    statsLeave(outer);
+
+    return result;
 }
 
 
+Set
+set_combine (Set a, Set b, SetOp op) {
+    SetListCursor ca, cb;
+    SetSource srcA = set_source_list(&ca, a);
+    SetSource srcB = set_source_list(&cb, b);
 
+    return set_merge_build(&srcA, &srcB, op);
+}
 
 
 Set
-set_symmetric_difference (Set a, Set b) {
-    Set new = EMPTY_SET;
-    Set curr = new; 
-    long last = 0;
+set_combine_all (const Set * sets, unsigned long count, SetOp op) {
+    SetListCursor * cursors = NULL;
+    SetSource * sources = NULL;
+    SetBuilder builder;
+    SetSink sink = set_sink_builder(&builder);
+    SetStatsOp outer = SET_STATS_BUILD;
+    unsigned long nodes = 0, i = 0;
+    Set result = EMPTY_SET;
+
+    assert(sets != NULL || count == 0);
+
+    if (count == 0) {
+        return EMPTY_SET;
+    }
+    if (count == 1) {
+        return set_copy(sets[0]);
+    }
 
-    /**hier wird geschaut welche der listen kleiner ist um last  zu belegen**/
-    if ((!SET_IS_EMPTY(a) && !SET_IS_EMPTY(b) && a->start <= b->start)) {
-        last = a->start-1;
+    cursors = malloc(count * sizeof(SetListCursor));
+    sources = malloc(count * sizeof(SetSource));
+    if (cursors == NULL || sources == NULL) {
+        exit(ERR_OUT_OF_MEMORY);
     }
-    else if ((!SET_IS_EMPTY(a) && !SET_IS_EMPTY(b) && a->start > b->start)) {
-        last = b->start-1;
+    for(i = 0; i < count; i++){
+        sources[i] = set_source_list(&cursors[i], sets[i]);
     }
 
-    /**die schleife ueber den algorithmus**/
-    while(!SET_IS_EMPTY(a) || !SET_IS_EMPTY(b)){
-        /**fuer den fall das b leer ist**/
-        if(SET_IS_EMPTY(b)){
-            if(a->start > last){
-                    last = a->start-1;
-                }
-             if(SET_IS_EMPTY(new)){
-                    new = createIntervall(last+1, a->end,NULL);
-                    curr = new;
-                    last = a->end;
-                    a = a->next;
-                }
-                else{
-                    if(last+1 == curr->end+1){
-                        curr->end = a->end;
-                        last = a->end;
-                        a = a->next;
-                    }
-                    else{
-                        curr->next = createIntervall(last+1, a->end,NULL);
-                        curr= curr->next;
-                        last = a->end;
-                        a = a->next;
-                    }
-                    
-                }  
-        } 
-        /**fuer den fall das a intervall komplett kleiner ist**/
-        else if ((!SET_IS_EMPTY(a) && !SET_IS_EMPTY(b) && a->start <= b->start)) {
-            if(a->end < b->start){
-                if(a->start > last){
-                    last = a->start-1;
-                }
-                if(SET_IS_EMPTY(new)){
-                    new = createIntervall(last+1, a->end,NULL);
-                    curr = new;
-                    last = a->end;
-                    a = a->next;
-                }
-                else{
-                    if(last+1 == curr->end+1){
-                        curr->end = a->end;
-                        last = a->end;
-                        a = a->next;
-                    }
-                    else{
-                        curr->next = createIntervall(last+1, a->end,NULL);
-                        curr= curr->next;
-                        last = a->end;
-                        a = a->next;
-                    }
-                }
-            }
-            /**falls das ende von a groesser  ist als  b start**/
-            else if(a->end >= b->start){
+    outer = statsEnter(SET_STATS_ALGEBRA);
+    set_builder_init(&builder);
+    set_merge_all(sources, count, op, &sink);
+    builderFlush(&builder);
+    nodes = builder.nodes;
+    result = set_builder_finish(&builder);
+    if (outer == SET_STATS_BUILD) {
+        stats.listLengths[statsBucket(nodes)]++;
+    }
+    statsLeave(outer);
 
-                if(a->start > last){
-                    last = a->start-1;
-                }
-                if(a->start == b->start){
-                        last = b->start;
-                    }
-                else if(SET_IS_EMPTY(new)){
-                    new = createIntervall(last+1, b->start-1,NULL);
-                    curr = new;
-                    last = b->start-1;
-                }
-                else{
-                    if(last+1 == curr->end+1){
-                        curr->end = b->start-1;
-                        last = b->start-1;
-                    }
-                    else{
-                        curr->next = createIntervall(last+1, b->start-1,NULL);
-                        last = b->start-1;
-                        curr= curr->next;
-                    }
-                }
-                /**wenn das ende  von a groesser ist als das ende  von b**/
-                if(a->end >= b->end){
-                    if(a->start == a->end){
-                        last = b->end;
-                        b = b->next;
-                        a = a->next;
-                    }else if(a->end == b->end){
-                        last = b->end;
-                        b = b->next;
-                        a = a->next;
-                    }
-                    else{
-                        last = b->end;
-                        b = b->next;   
-                    }      
-                }
-                else{
-                   last = a->end;
-                    a = a->next; 
-                }
-            }
-        }
+    free(cursors);
+    free(sources);
 
-        /**a ist leer  b nicht**/
-        else if(SET_IS_EMPTY(a)){
-            if(b->start > last){
-                    last = b->start-1;
-                }
-             if(SET_IS_EMPTY(new)){
-                    new = createIntervall(last+1, b->end,NULL);
-                    curr = new;
-                    last = b->end;
-                    b = b->next;
-                }
-                else{
-                    if(last+1 == curr->end+1){
-                        curr->end = b->end;
-                        last = b->end;
-                        b = b->next;
-                    }
-                    else{
-                        curr->next = createIntervall(last+1, b->end,NULL);
-                        curr= curr->next;
-                        last = b->end;
-                        b = b->next;
-                    }
-                    
-                }
-        } 
-        /**b kleiner als a**/
-        else if ((!SET_IS_EMPTY(a) && !SET_IS_EMPTY(b) && b->start <= a->start)) {
-            if(b->end < a->start){
-                if(b->start > last){
-                    last = b->start-1;
-                }
-                if(SET_IS_EMPTY(new)){
-                    new = createIntervall(last+1, b->end,NULL);
-                    curr = new;
-                    last = b->end;
-                    b = b->next;
-                }
-                else{
-                    if(last+1 == curr->end+1){
-                        curr->end = b->end;
-                        last = b->end;
-                        b = b->next;
-                    }
-                    else{
-                        curr->next = createIntervall(last+1, b->end,NULL);
-                        curr= curr->next;
-                        last = b->end;
-                        b = b->next;
-                    }
-                }
-            }
-            /**das ende von b ist groesser als a start**/
-            else if(b->end >= a->start){
-                if(b->start > last){
-                    last = b->start-1;
-                }
-                if(b->start == a->start){
-                        last = b->start;
-                    }
-                else if(SET_IS_EMPTY(new)){
-                    new = createIntervall(last+1, a->start-1,NULL);
-                    curr = new;
-                    last = a->start-1;
-                }
-                else{
-                    if(last+1 == curr->end+1){
-                        curr->end = a->start-1;
-                        last = a->start-1;
-                        
-                    }
-                    else{
-                        curr->next = createIntervall(last+1, a->start-1,NULL);
-                        last = a->start-1;
-                        curr= curr->next;
-                    }
-                }
-                /**das ende von bist  groesser  als  das ende von a**/
-                if(b->end >= a->end){
-                    if(b->start == b->end){
-                        last = a->end;
-                        b = b->next;
-                        a = a->next;
-                    }else if(a->end == b->end){
-                        last = a->end;
-                        b = b->next;
-                        a = a->next;
-                    }else{
-                        last = a->end;
-                        a = a->next;   
-                    } 
-                }
-                else{
-                   last = b->end;
-                    b = b->next; 
-                }
-            }
-        }
-    }
-    return new;
+    return result;
 }
 
 
+Set
+set_union (Set a, Set b) {
+    return set_combine(a, b, SET_OP_UNION);
+}
+
+
+Set
+set_intersection (Set a, Set b) {
+    return set_combine(a, b, SET_OP_INTERSECTION);
+}
+
+
+Set
+set_difference (Set a, Set b) {
+    return set_combine(a, b, SET_OP_DIFFERENCE);
+}
+
+
+Set
+set_symmetric_difference (Set a, Set b) {
+    return set_combine(a, b, SET_OP_SYMMETRIC_DIFFERENCE);
+}
+
+
+Set
+set_union_all (const Set * sets, unsigned long count) {
+    return set_combine_all(sets, count, SET_OP_UNION);
+}
+
+
+Set
+set_intersection_all (const Set * sets, unsigned long count) {
+    return set_combine_all(sets, count, SET_OP_INTERSECTION);
+}
 
 
 Set
 set_copy (Set s) {
-    Set new = EMPTY_SET;
-    Set curr = s;
-    Set newCurr = new;
-    
-    if (SET_IS_EMPTY(s)) {
-        return EMPTY_SET;
+    /* die Kopie teilt sich alle Knoten mit s, erst Aenderungen kopieren
+     * die betroffenen Knoten */
+    if (!SET_IS_EMPTY(s)) {
+        s->refs++;
     }
-    
 
-    while(!SET_IS_EMPTY(curr)){
-        /**falls wir noch keine liste haben**/
-        if(SET_IS_EMPTY(new)){
-            new = createIntervall(curr->start, curr->end, EMPTY_SET);
-            newCurr = new;
-            curr = curr->next;
+    return s;
+}
+
+/** Platz einer Zahl samt Vorzeichen und Trennzeichen im Puffer von set_print_as */
+#define PRINT_NUMBER_CHARS 24
+
+/**
+ * Puffer, in dem set_print_as die Ausgabe sammelt.
+ */
+typedef struct {
+    /** der Ausgabestrom */
+    FILE * stream;
+    /** die gesammelten Zeichen */
+    char buffer[SET_PRINT_BUFFER];
+    /** Anzahl der Zeichen im Puffer */
+    size_t fill;
+} PrintBuffer;
+
+/**
+ * Schreibt den Puffer in den Ausgabestrom und leert ihn.
+ *
+ * @param[in,out] out der Puffer.
+ */
+static void
+printFlush (PrintBuffer * out) {
+    fwrite(out->buffer, 1, out->fill, out->stream);
+    out->fill = 0;
+}
+
+/**
+ * Stellt sicher, dass mindestens PRINT_NUMBER_CHARS Zeichen in den Puffer passen.
+ *
+ * @param[in,out] out der Puffer.
+ */
+static void
+printReserve (PrintBuffer * out) {
+    if (out->fill + PRINT_NUMBER_CHARS > SET_PRINT_BUFFER) {
+        printFlush(out);
+    }
+}
+
+/**
+ * Haengt eine kurze Zeichenkette (hoechstens PRINT_NUMBER_CHARS Zeichen) an den Puffer an.
+ *
+ * @param[in,out] out  der Puffer.
+ * @param[in]     text die Zeichenkette.
+ */
+static void
+printText (PrintBuffer * out, const char * text) {
+    size_t length = strlen(text);
+
+    printReserve(out);
+    memcpy(out->buffer + out->fill, text, length);
+    out->fill += length;
+}
+
+/**
+ * Schreibt eine Zahl dezimal ohne abschliessendes Nullzeichen.
+ *
+ * @param[in]  e      die Zahl.
+ * @param[out] digits Ziel, mindestens PRINT_NUMBER_CHARS - 1 Zeichen.
+ *
+ * @return Anzahl der geschriebenen Zeichen.
+ */
+static size_t
+formatElement (Element e, char * digits) {
+    char reversed[PRINT_NUMBER_CHARS];
+    unsigned long magnitude = e < 0 ? 0UL - (unsigned long) e : (unsigned long) e;
+    size_t length = 0, i = 0;
+
+    do {
+        reversed[length++] = (char) ('0' + magnitude % 10);
+        magnitude /= 10;
+    } while(magnitude != 0);
+
+    if (e < 0) {
+        digits[i++] = '-';
+    }
+    while(length > 0){
+        digits[i++] = reversed[--length];
+    }
+    return i;
+}
+
+/**
+ * Haengt die Elemente eines Intervalls einzeln an den Puffer an, hoechstens
+ * jedoch *left Elemente.
+ *
+ * Ab dem ersten nicht negativen Element wird die Ziffernfolge des Vorgaengers
+ * nur hochgezaehlt, statt jede Zahl neu umzurechnen.
+ *
+ * @param[in,out] out   der Puffer.
+ * @param[in]     start das kleinste Element des Intervalls.
+ * @param[in]     end   das groesste Element des Intervalls.
+ * @param[in,out] left  Anzahl der noch auszugebenden Elemente.
+ * @param[in,out] first 1, solange noch kein Element ausgegeben wurde.
+ *
+ * @return 1, falls das ganze Intervall ausgegeben wurde, 0 falls *left vorher 0 wurde.
+ */
+static int
+printRun (PrintBuffer * out, Element start, Element end, unsigned long * left, int * first) {
+    char digits[PRINT_NUMBER_CHARS];
+    size_t length = 0, i = 0;
+    Element e = start;
+
+    /* bei negativen Elementen sinkt der Betrag, sie werden einzeln umgerechnet */
+    while(e < 0){
+        if (*left == 0) {
+            return 0;
         }
-        else{
-        newCurr->next = createIntervall(curr->start, curr->end, EMPTY_SET);
-        newCurr = newCurr->next;
-        curr = curr->next;
+        printReserve(out);
+        if (!*first) {
+            out->buffer[out->fill++] = ',';
+        }
+        out->fill += formatElement(e, out->buffer + out->fill);
+        *first = 0;
+        (*left)--;
+        if (e == end) {
+            return 1;
+        }
+        e++;
+    }
+
+    length = formatElement(e, digits);
+    for(;;){
+        if (*left == 0) {
+            return 0;
+        }
+        printReserve(out);
+        if (!*first) {
+            out->buffer[out->fill++] = ',';
+        }
+        memcpy(out->buffer + out->fill, digits, length);
+        out->fill += length;
+        *first = 0;
+        (*left)--;
+        if (e == end) {
+            return 1;
+        }
+        e++;
+
+        /* Ziffernfolge um eins erhoehen */
+        i = length;
+        while(i > 0 && digits[i - 1] == '9'){
+            digits[--i] = '0';
+        }
+        if (i == 0) {
+            memmove(digits + 1, digits, length);
+            digits[0] = '1';
+            length++;
+        } else {
+            digits[i - 1]++;
         }
     }
-    
-    assert (set_equals(s,new));
-    return new; 
 }
 
 void
 set_print (FILE * stream, Set s) {
+    set_print_as(stream, s, SET_PRINT_EXPANDED, 0);
+}
 
-    Set curr = s;
-    long i = 0;
+
+void
+set_print_as (FILE * stream, Set s, SetPrintMode mode, unsigned long limit) {
+
+    PrintBuffer out;
+    SetListCursor cursor;
+    Element start = 0, end = 0;
+    unsigned long left = mode == SET_PRINT_PREVIEW ? limit : ULONG_MAX;
+    int first = 1, complete = 1;
 
     assert(stream != NULL);
 
-    fprintf(stream, "{");
+    out.stream = stream;
+    out.fill = 0;
+    printText(&out, "{");
 
-    while(!SET_IS_EMPTY(curr)){
-        
-        for(i = curr->start; i <= curr->end; i++)
-        {   if(SET_IS_EMPTY(curr->next) && i == curr->end){
-                fprintf(stream, "%ld", i);
-            }            
-            else{
-                fprintf(stream, "%ld,", i);
+    cursorInit(&cursor, s, EMPTY_SET);
+    while(complete && listSourceNext(&cursor, &start, &end)){
+        if (mode == SET_PRINT_INTERVALS) {
+            printReserve(&out);
+            if (!first) {
+                out.buffer[out.fill++] = ',';
+            }
+            out.fill += formatElement(start, out.buffer + out.fill);
+            if (end != start) {
+                printReserve(&out);
+                out.buffer[out.fill++] = '.';
+                out.buffer[out.fill++] = '.';
+                out.fill += formatElement(end, out.buffer + out.fill);
             }
+            first = 0;
+        } else {
+            complete = printRun(&out, start, end, &left, &first);
         }
-        curr = curr->next;
     }
-    fprintf(stream, "}");
+
+    if (!complete) {
+        printText(&out, first ? "..." : ",...");
+    }
+    printText(&out, "}");
+    printFlush(&out);
 }
 
 
@@ -943,6 +1525,7 @@ void
 set_print_list (FILE * stream, Set s) {
 
     Set curr = s;
+    unsigned int i = 0;
 
     assert(stream != NULL);
 
@@ -952,8 +1535,519 @@ set_print_list (FILE * stream, Set s) {
     }
     else{
         while(!SET_IS_EMPTY(curr)){
-            fprintf(stream, "[%ld:%ld]", curr->start,curr->end);
+            if (curr->bits == NULL) {
+                for(i = 0; i < curr->count; i++){
+                    fprintf(stream, "[%ld:%ld]", curr->starts[i],curr->ends[i]);
+                }
+            } else {
+                /* Bitmap-Block: kleinstes und groesstes Element, Anzahl */
+                fprintf(stream, "<%ld:%ld:%lu>", NODE_FIRST(curr), NODE_LAST(curr), nodeCardinality(curr));
+            }
             curr = curr->next;
         }
     }
 }
+
+
+/**
+ * Schreibt eine vorzeichenlose Zahl als Varint (7 Bit je Byte, niederwertige
+ * Gruppe zuerst, das oberste Bit zeigt ein Folgebyte an).
+ *
+ * @param[in] stream Datei bzw. Stream, in den geschrieben wird.
+ * @param[in] value  die Zahl.
+ */
+static void
+writeVarint (FILE * stream, unsigned long value) {
+    while(value >= 0x80){
+        putc((int) ((value & 0x7F) | 0x80), stream);
+        value >>= 7;
+    }
+    putc((int) value, stream);
+}
+
+/**
+ * Liest eine vorzeichenlose Zahl im Varint-Format (siehe writeVarint).
+ *
+ * @param[in]  stream Datei bzw. Stream, aus dem gelesen wird.
+ * @param[out] value  die Zahl.
+ *
+ * @return 1, falls eine Zahl gelesen wurde, 0 am Dateiende oder bei einem Ueberlauf.
+ */
+static int
+readVarint (FILE * stream, unsigned long * value) {
+    unsigned long group = 0;
+    unsigned int shift = 0;
+    int c = 0;
+
+    *value = 0;
+    do {
+        c = getc(stream);
+        if (c == EOF || shift >= WORD_BITS) {
+            return 0;
+        }
+        group = (unsigned long) (c & 0x7F);
+        if (((group << shift) >> shift) != group) {
+            return 0;
+        }
+        *value |= group << shift;
+        shift += 7;
+    } while(c & 0x80);
+
+    return 1;
+}
+
+/**
+ * Addiert einen vorzeichenlosen Abstand zu einem Element, ohne dass ein
+ * Zwischenergebnis ueberlaeuft.
+ *
+ * @param[in] e      das Element.
+ * @param[in] offset der Abstand.
+ *
+ * @return e + offset.
+ *
+ * @pre e + offset <= LONG_MAX
+ */
+static Element
+elementAdd (Element e, unsigned long offset) {
+    if (offset > (unsigned long) LONG_MAX) {
+        e += LONG_MAX;
+        offset -= (unsigned long) LONG_MAX;
+    }
+    return e + (Element) offset;
+}
+
+
+int
+set_save (FILE * stream, Set s) {
+    SetListCursor cursor;
+    Element start = 0, end = 0, last = 0;
+    unsigned long count = 0;
+    int first = 1;
+
+    assert(stream != NULL);
+
+    cursorInit(&cursor, s, EMPTY_SET);
+    while(listSourceNext(&cursor, &start, &end)){
+        count++;
+    }
+
+    fwrite(SET_FILE_MAGIC, 1, sizeof(SET_FILE_MAGIC) - 1, stream);
+    writeVarint(stream, count);
+
+    cursorInit(&cursor, s, EMPTY_SET);
+    while(listSourceNext(&cursor, &start, &end)){
+        if (first) {
+            /* ZigZag-Code, damit kleine negative Anfaenge kurz bleiben */
+            writeVarint(stream, start < 0 ? ((unsigned long) -(start + 1) << 1) | 1 : (unsigned long) start << 1);
+        } else {
+            writeVarint(stream, (unsigned long) start - (unsigned long) last - 2);
+        }
+        writeVarint(stream, (unsigned long) end - (unsigned long) start);
+        last = end;
+        first = 0;
+    }
+
+    return !ferror(stream);
+}
+
+
+int
+set_load (FILE * stream, Set * s) {
+    SetBuilder builder;
+    char magic[sizeof(SET_FILE_MAGIC) - 1];
+    unsigned long count = 0, i = 0, gap = 0, length = 0;
+    Element start = 0, end = 0;
+    int ok = 0;
+
+    assert(stream != NULL);
+    assert(s != NULL);
+
+    ok = fread(magic, 1, sizeof(magic), stream) == sizeof(magic)
+        && memcmp(magic, SET_FILE_MAGIC, sizeof(magic)) == 0
+        && readVarint(stream, &count);
+
+    set_builder_init(&builder);
+    for(i = 0; ok && i < count; i++){
+        ok = readVarint(stream, &gap) && readVarint(stream, &length);
+        if (ok && i == 0) {
+            start = (gap & 1) ? -(Element) (gap >> 1) - 1 : (Element) (gap >> 1);
+        } else if (ok) {
+            /* der Anfang muss hinter end + 1 liegen und darstellbar sein */
+            ok = (unsigned long) LONG_MAX - (unsigned long) end >= 2
+                && gap <= (unsigned long) LONG_MAX - (unsigned long) end - 2;
+            if (ok) {
+                start = elementAdd(end, gap + 2);
+            }
+        }
+        ok = ok && length <= (unsigned long) LONG_MAX - (unsigned long) start;
+        if (ok) {
+            end = elementAdd(start, length);
+            set_builder_append_range(&builder, start, end);
+        }
+    }
+
+    *s = set_builder_finish(&builder);
+    if (!ok) {
+        *s = set_clear(*s);
+    }
+    return ok;
+}
+
+
+void
+set_builder_init (SetBuilder * b) {
+    assert(b != NULL);
+
+    b->head = EMPTY_SET;
+    b->tail = EMPTY_SET;
+    b->nodes = 0;
+    b->stats = &stats;
+    b->running = 0;
+    b->runStart = 0;
+    b->runEnd = 0;
+    b->chunkBase = 0;
+    b->count = 0;
+    b->bits = NULL;
+    b->bitsMin = 0;
+    b->bitsMax = 0;
+}
+
+
+/**
+ * Haengt einen Knoten an die Liste eines Builders an.
+ *
+ * @param[in,out] b    der Builder.
+ * @param[in]     node der Knoten.
+ */
+static void
+builderCommitNode (SetBuilder * b, Set node) {
+    if (SET_IS_EMPTY(b->tail)) {
+        b->head = node;
+    } else {
+        b->tail->next = node;
+    }
+    b->tail = node;
+    b->nodes++;
+}
+
+/**
+ * Haengt ein Intervall an die Liste eines Builders an. Grenzt es direkt an das
+ * letzte Intervall an, wird dieses verlaengert, ansonsten wird es im letzten
+ * Knoten ergaenzt oder, wenn dieser voll ist, in einem neuen Knoten abgelegt.
+ *
+ * @param[in,out] b     der Builder.
+ * @param[in]     start der Anfang des Intervalls.
+ * @param[in]     end   das Ende des Intervalls.
+ */
+static void
+builderCommitIntervall (SetBuilder * b, Element start, Element end) {
+    Set tail = b->tail;
+
+    if (SET_IS_EMPTY(tail) || tail->bits != NULL) {
+        builderCommitNode(b, createNode(b->stats, start, end, EMPTY_SET));
+    } else if (NODE_LAST(tail) + 1 == start) {
+        NODE_LAST(tail) = end;
+    } else if (tail->count < SET_NODE_INTERVALS) {
+        tail->starts[tail->count] = start;
+        tail->ends[tail->count] = end;
+        tail->count++;
+    } else {
+        builderCommitNode(b, createNode(b->stats, start, end, EMPTY_SET));
+    }
+}
+
+/**
+ * Legt die gesammelten Intervalle des aktuellen Blocks ab, je nach
+ * Zersplitterung als Intervalle oder als ein Bitmap-Knoten.
+ *
+ * @param[in,out] b der Builder.
+ */
+static void
+builderFlushChunk (SetBuilder * b) {
+    unsigned int i = 0;
+
+    if (b->bits != NULL) {
+        builderCommitNode(b, createChunk(b->stats, b->bitsMin, b->bitsMax, b->bits, EMPTY_SET));
+        b->bits = NULL;
+    } else {
+        for(i = 0; i < b->count; i++){
+            builderCommitIntervall(b, b->starts[i], b->ends[i]);
+        }
+    }
+    b->count = 0;
+}
+
+/**
+ * Sammelt ein Intervall des aktuellen Blocks. Wird der Block dabei zu stark
+ * zersplittert, wird er auf eine Bitmap umgestellt.
+ *
+ * @param[in,out] b     der Builder.
+ * @param[in]     start der Anfang des Intervalls.
+ * @param[in]     end   das Ende des Intervalls.
+ *
+ * @pre start und end liegen im aktuellen Block hinter allen gesammelten Intervallen.
+ */
+static void
+builderAddToChunk (SetBuilder * b, Element start, Element end) {
+    unsigned int i = 0;
+
+    if (b->bits == NULL && b->count < SET_CHUNK_MAX_INTERVALS) {
+        b->starts[b->count] = start;
+        b->ends[b->count] = end;
+        b->count++;
+        return;
+    }
+
+    if (b->bits == NULL) {
+        b->bits = allocate(b->stats, CHUNK_BYTES, 1);
+        for(i = 0; i < b->count; i++){
+            setBits(b->bits, b->chunkBase, b->starts[i], b->ends[i]);
+        }
+        b->bitsMin = b->starts[0];
+        b->count = 0;
+    }
+    setBits(b->bits, b->chunkBase, start, end);
+    b->bitsMax = end;
+}
+
+/**
+ * Legt ein fertiges Intervall ab und verteilt es dazu auf die Bloecke, die es
+ * beruehrt.
+ *
+ * @param[in,out] b     der Builder.
+ * @param[in]     start der Anfang des Intervalls.
+ * @param[in]     end   das Ende des Intervalls.
+ */
+static void
+builderPlace (SetBuilder * b, Element start, Element end) {
+    Element last = 0;
+
+    while(1){
+        if ((b->count > 0 || b->bits != NULL) && chunkBase(start) != b->chunkBase) {
+            builderFlushChunk(b);
+        }
+        if (b->count == 0 && b->bits == NULL) {
+            b->chunkBase = chunkBase(start);
+        }
+        last = b->chunkBase + (SET_CHUNK_BITS - 1);
+        if (end <= last) {
+            builderAddToChunk(b, start, end);
+            return;
+        }
+        builderAddToChunk(b, start, last);
+        builderFlushChunk(b);
+        start = last + 1;
+
+        /* vollstaendig ueberdeckte Bloecke sind nicht zersplittert und werden
+         * direkt als Intervall abgelegt */
+        if (chunkBase(end) > start) {
+            builderCommitIntervall(b, start, chunkBase(end) - 1);
+            start = chunkBase(end);
+        }
+    }
+}
+
+/**
+ * Legt alle noch nicht abgelegten Intervalle eines Builders ab, so dass
+ * b->tail der letzte Knoten der aufgebauten Liste ist.
+ *
+ * @param[in,out] b der Builder.
+ */
+static void
+builderFlush (SetBuilder * b) {
+    if (b->running) {
+        builderPlace(b, b->runStart, b->runEnd);
+        b->running = 0;
+    }
+    builderFlushChunk(b);
+}
+
+
+void
+set_builder_append (SetBuilder * b, Element e) {
+    set_builder_append_range(b, e, e);
+}
+
+
+void
+set_builder_append_range (SetBuilder * b, Element start, Element end) {
+    assert(b != NULL);
+    assert(start <= end);
+
+    if (!b->running) {
+        b->running = 1;
+        b->runStart = start;
+        b->runEnd = end;
+        return;
+    }
+
+    assert(start >= b->runStart);
+
+    /* ueberschneidet oder grenzt direkt an das letzte Intervall an */
+    if (start <= b->runEnd || start - 1 == b->runEnd) {
+        if (end > b->runEnd) {
+            b->runEnd = end;
+        }
+    }
+    else {
+        builderPlace(b, b->runStart, b->runEnd);
+        b->runStart = start;
+        b->runEnd = end;
+    }
+}
+
+
+Set
+set_builder_finish (SetBuilder * b) {
+    Set result = EMPTY_SET;
+
+    assert(b != NULL);
+
+    builderFlush(b);
+    result = b->head;
+    if (statsOp == SET_STATS_BUILD) {
+        b->stats->calls[SET_STATS_BUILD]++;
+        b->stats->listLengths[statsBucket(b->nodes)]++;
+    }
+    b->head = EMPTY_SET;
+    b->tail = EMPTY_SET;
+    b->nodes = 0;
+
+    return result;
+}
+
+
+void
+set_stats_get (SetStats * result) {
+    assert(result != NULL);
+
+    *result = stats;
+}
+
+
+void
+set_stats_add (const SetStats * local, SetStatsOp op) {
+    unsigned int k = 0;
+
+    assert(local != NULL);
+
+    setlist_refs += (int) local->liveNodes;
+    stats.liveNodes += local->liveNodes;
+    stats.liveBitmaps += local->liveBitmaps;
+    stats.bytesInUse += local->bytesInUse;
+    stats.allocations += local->allocations;
+    stats.releases += local->releases;
+    stats.calls[op]++;
+    stats.allocs[op] += local->allocations;
+    for(k = 0; k < SET_STATS_BUCKETS; k++){
+        stats.listLengths[k] += local->listLengths[k];
+    }
+    if (stats.liveNodes > stats.peakNodes) {
+        stats.peakNodes = stats.liveNodes;
+    }
+    if (stats.bytesInUse > stats.peakBytes) {
+        stats.peakBytes = stats.bytesInUse;
+    }
+}
+
+
+void
+set_stats_reset (void) {
+    unsigned long liveNodes = stats.liveNodes;
+    unsigned long liveBitmaps = stats.liveBitmaps;
+    unsigned long bytesInUse = stats.bytesInUse;
+
+    memset(&stats, 0, sizeof(SetStats));
+    stats.liveNodes = liveNodes;
+    stats.peakNodes = liveNodes;
+    stats.liveBitmaps = liveBitmaps;
+    stats.bytesInUse = bytesInUse;
+    stats.peakBytes = bytesInUse;
+}
+
+
+void
+set_stats_shape (Set s, SetShape * shape) {
+    SetListCursor cursor;
+    Element start = 0, end = 0;
+    unsigned long length = 0;
+    Set curr = s;
+
+    assert(shape != NULL);
+
+    memset(shape, 0, sizeof(SetShape));
+    for(curr = s; !SET_IS_EMPTY(curr); curr = curr->next){
+        shape->nodes++;
+        if (curr->bits != NULL) {
+            shape->bitmapNodes++;
+        }
+    }
+
+    cursorInit(&cursor, s, EMPTY_SET);
+    while(listSourceNext(&cursor, &start, &end)){
+        length = (unsigned long) end - (unsigned long) start + 1;
+        shape->intervals++;
+        shape->elements += length;
+        shape->intervalLengths[statsBucket(length)]++;
+    }
+    if (shape->intervals > 0) {
+        shape->averageIntervalLength = (double) shape->elements / (double) shape->intervals;
+    }
+}
+
+
+/**
+ * Schreibt die belegten Klassen einer Haeufigkeitsverteilung als Zeilen
+ * "name.untergrenze=anzahl".
+ *
+ * @param[in] stream Ausgabestrom.
+ * @param[in] name   Name der Verteilung.
+ * @param[in] counts die Verteilung.
+ */
+static void
+printBuckets (FILE * stream, const char * name, const unsigned long counts[]) {
+    unsigned int k = 0;
+
+    for(k = 0; k < SET_STATS_BUCKETS; k++){
+        if (counts[k] != 0) {
+            fprintf(stream, "%s.%lu=%lu\n", name, k == 0 ? 0UL : 1UL << (k - 1), counts[k]);
+        }
+    }
+}
+
+
+void
+set_stats_print (FILE * stream, const SetStats * s) {
+    static const char * names[SET_STATS_OPS] = { "build", "insert", "remove", "algebra" };
+    unsigned int op = 0;
+
+    assert(stream != NULL);
+    assert(s != NULL);
+
+    fprintf(stream, "stats.live_nodes=%lu\n", s->liveNodes);
+    fprintf(stream, "stats.peak_nodes=%lu\n", s->peakNodes);
+    fprintf(stream, "stats.live_bitmaps=%lu\n", s->liveBitmaps);
+    fprintf(stream, "stats.bytes_in_use=%lu\n", s->bytesInUse);
+    fprintf(stream, "stats.peak_bytes=%lu\n", s->peakBytes);
+    fprintf(stream, "stats.allocations=%lu\n", s->allocations);
+    fprintf(stream, "stats.releases=%lu\n", s->releases);
+    for(op = 0; op < SET_STATS_OPS; op++){
+        fprintf(stream, "stats.calls.%s=%lu\n", names[op], s->calls[op]);
+        fprintf(stream, "stats.allocs.%s=%lu\n", names[op], s->allocs[op]);
+    }
+    printBuckets(stream, "stats.list_length", s->listLengths);
+}
+
+
+void
+set_stats_print_shape (FILE * stream, const SetShape * shape) {
+    assert(stream != NULL);
+    assert(shape != NULL);
+
+    fprintf(stream, "shape.nodes=%lu\n", shape->nodes);
+    fprintf(stream, "shape.bitmap_nodes=%lu\n", shape->bitmapNodes);
+    fprintf(stream, "shape.intervals=%lu\n", shape->intervals);
+    fprintf(stream, "shape.elements=%lu\n", shape->elements);
+    fprintf(stream, "shape.average_interval_length=%.2f\n", shape->averageIntervalLength);
+    printBuckets(stream, "shape.interval_length", shape->intervalLengths);
+}
@@ -11,18 +11,69 @@
  *   Vorgaengerintervall hat, muss sein Anfang nach dem Ende des Vorgaengerintervalls
  *   liegen. Intervalle duerfen sich hierbei also weder ueberschneiden noch direkt 
  *   aneinander angrenzen. (Intervallanfang > Ende Vorgaengerintervall +1)
+ *
+ * Stark zersplitterte Bereiche werden statt als Intervall-Liste als Bitmap
+ * gespeichert: Der Wertebereich ist in Bloecke zu je SET_CHUNK_BITS Elementen
+ * eingeteilt. Enthaelt ein Block mehr als SET_CHUNK_MAX_INTERVALS Intervalle, wird
+ * sein gesamter Inhalt in einem einzigen Bitmap-Knoten abgelegt, dessen einziges
+ * Intervall das kleinste und groesste enthaltene Element angibt. Ein Bitmap-Knoten darf
+ * direkt an seine Nachbarknoten angrenzen. Die Darstellung wird bei jeder Aenderung
+ * blockweise neu entschieden und ist nach aussen nicht sichtbar.
  * 
  * Die Verwaltung des benoetigten Speichers findet komplett innerhalb dieses Moduls statt.
  *
+ * Listenknoten werden ueber einen Referenzzaehler von mehreren Mengen gemeinsam
+ * genutzt: set_copy liefert in konstanter Zeit eine Menge, die sich alle Knoten
+ * mit dem Original teilt. Veraendernde Operationen kopieren nur die geteilten
+ * Knoten vom Listenanfang bis zur Aenderungsstelle (copy-on-write), alle
+ * anderen Mengen sehen die Aenderung daher nicht.
+ *
  * @author alexander loeffler, andre kloodt
  */
 
 /** Datentyp der Mengenelemente */
 typedef long Element; 
 
+#ifndef SET_NODE_INTERVALS
+/** Hoechstzahl der Intervalle eines Listenknotens */
+#define SET_NODE_INTERVALS 4
+#endif
+
 /* TODO Typdefinition Set als Intervall-Liste */
 typedef struct Intervall *Set;
-struct Intervall { Element start; Element end; Set next; };
+
+/**
+ * Knoten einer Intervall-Liste. Ein Intervallknoten fasst bis zu
+ * SET_NODE_INTERVALS aufeinander folgende Intervalle zusammen, so dass beim
+ * Durchlaufen der Liste nur alle SET_NODE_INTERVALS Intervalle ein neuer Knoten
+ * (und damit ein Cache-Fehlzugriff) anfaellt. Die fuer das Ueberspringen
+ * benoetigten Felder liegen dabei am Knotenanfang.
+ */
+struct Intervall {
+  /** naechster Knoten */
+  Set next;
+  /** Anzahl der Intervalle im Knoten (1 bei Bitmap-Knoten) */
+  unsigned int count;
+  /** Enden der Intervalle, aufsteigend sortiert */
+  Element ends[SET_NODE_INTERVALS];
+  /** Anfaenge der Intervalle, aufsteigend sortiert */
+  Element starts[SET_NODE_INTERVALS];
+  /** Anzahl der Listen (bzw. Knoten), die auf diesen Knoten verweisen */
+  unsigned long refs;
+  /** Bitmap eines Blocks oder NULL bei Intervallknoten */
+  unsigned long * bits;
+};
+
+#ifndef SET_CHUNK_BITS
+/** Anzahl der Elemente eines Blocks (Zweierpotenz, Vielfaches der Bits von unsigned long) */
+#define SET_CHUNK_BITS 4096
+#endif
+
+#ifndef SET_CHUNK_MAX_INTERVALS
+/** Hoechstzahl der Intervalle eines Blocks, bevor er als Bitmap gespeichert wird
+ * (>= SET_NODE_INTERVALS) */
+#define SET_CHUNK_MAX_INTERVALS 16
+#endif
 
 /** Leere Menge zur Initialisierung von Variablen. */
 #define EMPTY_SET NULL
@@ -59,6 +110,42 @@ Set set_insert (Set s, Element e);
  */
 Set set_remove (Set s, Element e);
 
+/**
+ * Fuegt alle Elemente des Intervalls [start, end] in die Menge s ein.
+ *
+ * Die Menge s wird hierbei veraendert. Dabei werden in einem einzigen Durchlauf
+ * alle Intervalle, die vom Bereich ueberdeckt werden oder direkt an ihn
+ * angrenzen, zu einem Intervall verschmolzen.
+ *
+ * @param[in,out] s     die Menge.
+ * @param[in]     start der Anfang des einzufuegenden Bereichs.
+ * @param[in]     end   das Ende des einzufuegenden Bereichs.
+ *
+ * @return die Menge s, in die der Bereich eingefuegt wurde.
+ *
+ * @pre start <= end
+ * @post die Menge enthaelt alle Elemente von start bis end.
+ */
+Set set_insert_range (Set s, Element start, Element end);
+
+/**
+ * Entfernt alle Elemente des Intervalls [start, end] aus der Menge s.
+ *
+ * Die Menge s wird hierbei veraendert. Dabei werden in einem einzigen Durchlauf
+ * ueberdeckte Intervalle geloescht und angeschnittene Intervalle gekuerzt bzw.
+ * aufgeteilt.
+ *
+ * @param[in,out] s     die Menge.
+ * @param[in]     start der Anfang des zu loeschenden Bereichs.
+ * @param[in]     end   das Ende des zu loeschenden Bereichs.
+ *
+ * @return die Menge s, aus der der Bereich geloescht wurde.
+ *
+ * @pre start <= end
+ * @post die Menge enthaelt kein Element von start bis end.
+ */
+Set set_remove_range (Set s, Element start, Element end);
+
 /**
  * Entfernt alle Elemente aus der Menge s. 
  *
@@ -122,6 +209,67 @@ Element set_min (Set s);
  */
 int set_contains (Set s, Element e);
 
+/**
+ * Prueft fuer viele Elemente auf einmal, ob sie in der Menge s enthalten sind.
+ *
+ * Die Anfragen werden (soweit sie nicht bereits aufsteigend sortiert sind)
+ * sortiert und dann in einem einzigen gemeinsamen Durchlauf mit der Liste
+ * beantwortet. Die Kosten betragen damit O(n * log(n) + Laenge der Liste)
+ * statt O(n * Laenge der Liste).
+ *
+ * Die Menge s und die Anfragen bleiben hierbei unveraendert.
+ *
+ * @param[in]  s       die Menge.
+ * @param[in]  queries die zu pruefenden Elemente.
+ * @param[in]  n       die Anzahl der Elemente.
+ * @param[out] results fuer jedes Element 1, falls es enthalten ist, sonst 0.
+ *
+ * @pre queries und results sind nicht der Nullzeiger oder n ist 0.
+ */
+void set_contains_many (Set s, const Element queries[], unsigned long n, int results[]);
+
+/**
+ * Leseposition fuer eine Folge von Anfragen an eine Menge. Bei aufsteigenden
+ * Anfragen setzt jede Suche dort fort, wo die vorherige aufgehoert hat.
+ *
+ * Die Menge darf waehrend der Verwendung des Cursors nicht veraendert werden.
+ */
+typedef struct {
+  /** Anfang der Liste */
+  Set head;
+  /** erstes Intervall, das nicht vor der letzten Anfrage endet */
+  Set pos;
+  /** die letzte Anfrage, alle Intervalle vor pos enden davor */
+  Element floor;
+} SetCursor;
+
+/**
+ * Initialisiert einen Cursor am Anfang der Menge s.
+ *
+ * @param[out] c der Cursor.
+ * @param[in]  s die Menge.
+ *
+ * @pre c ist nicht der Nullzeiger.
+ */
+void set_cursor_init (SetCursor * c, Set s);
+
+/**
+ * Prueft, ob ein Element in der Menge des Cursors enthalten ist.
+ *
+ * Ist e nicht kleiner als die vorherige Anfrage, wird die Suche an der
+ * aktuellen Position fortgesetzt, sodass eine aufsteigende Folge von Anfragen
+ * insgesamt nur einen Listendurchlauf kostet. Andernfalls beginnt die Suche
+ * wieder am Listenanfang.
+ *
+ * @param[in,out] c der Cursor.
+ * @param[in]     e das zu pruefende Element.
+ *
+ * @return 1, falls Element enthalten ist, sonst 0.
+ *
+ * @pre c ist nicht der Nullzeiger.
+ */
+int set_cursor_contains (SetCursor * c, Element e);
+
 /**
  * Prueft, ob die Menge a Untermenge der Menge b ist, also alle Elemente von a
  * auch in b enthalten sind.
@@ -204,9 +352,45 @@ Set set_difference (Set a, Set b);
  */
 Set set_symmetric_difference (Set a, Set b);
 
+/**
+ * Erzeugt die Vereinigungsmenge der count Mengen sets[0] bis sets[count - 1]
+ * in einem gemeinsamen Durchlauf (siehe set_merge_all). Bei vielen Mengen ist
+ * das deutlich schneller als wiederholtes set_union, das die wachsende
+ * Zwischenmenge jedes Mal kopiert.
+ *
+ * Die Mengen bleiben hierbei unveraendert.
+ *
+ * @param[in] sets  die Mengen.
+ * @param[in] count Anzahl der Mengen.
+ *
+ * @return die Vereinigungsmenge aller Mengen, die leere Menge bei count 0.
+ *
+ * @pre sets ist nicht der Nullzeiger oder count ist 0.
+ */
+Set set_union_all (const Set * sets, unsigned long count);
+
+/**
+ * Erzeugt die Schnittmenge der count Mengen sets[0] bis sets[count - 1] in
+ * einem gemeinsamen Durchlauf (siehe set_merge_all).
+ *
+ * Die Mengen bleiben hierbei unveraendert.
+ *
+ * @param[in] sets  die Mengen.
+ * @param[in] count Anzahl der Mengen.
+ *
+ * @return die Schnittmenge aller Mengen, die leere Menge bei count 0.
+ *
+ * @pre sets ist nicht der Nullzeiger oder count ist 0.
+ */
+Set set_intersection_all (const Set * sets, unsigned long count);
+
 /**
  * Erzeugt eine Kopie der Menge s.
  *
+ * Die Kopie teilt sich alle Knoten mit s und wird daher in konstanter Zeit
+ * erzeugt. Erst eine spaetere Aenderung an einer der beiden Mengen kopiert
+ * die betroffenen Knoten.
+ *
  * Die Menge s bleibt hierbei unveraendert.
  *
  * @param[in] s die Ausgangsmenge.
@@ -217,8 +401,26 @@ Set set_symmetric_difference (Set a, Set b);
  */
 Set set_copy (Set s);
 
+/** Groesse des Puffers, in dem set_print die Ausgabe sammelt */
+#ifndef SET_PRINT_BUFFER
+#define SET_PRINT_BUFFER 65536
+#endif
+
+/**
+ * Formen der Stringrepraesentation einer Menge.
+ */
+typedef enum SetPrintMode {
+  /** jedes Element einzeln, z.B. {1,2,3,7} */
+  SET_PRINT_EXPANDED = 0,
+  /** jedes Intervall als Bereich, z.B. {1..3,7}, wieder einlesbar */
+  SET_PRINT_INTERVALS,
+  /** die ersten Elemente einzeln, danach "...", z.B. {1,2,...} */
+  SET_PRINT_PREVIEW
+} SetPrintMode;
+
 /**
  * Schreibt die Stringrepraesentation der Menge s in den uebergebenen Ausgabestrom.
+ * Entspricht set_print_as mit SET_PRINT_EXPANDED.
  *
  * @pre stream ist nicht der Nullzeiger.
  * @param[in] stream Ausgabestrom.
@@ -226,6 +428,25 @@ Set set_copy (Set s);
  */
 void set_print (FILE * stream, Set s);
 
+/**
+ * Schreibt die Stringrepraesentation der Menge s in der gewaehlten Form in den
+ * uebergebenen Ausgabestrom.
+ *
+ * Die Zahlen werden ohne fprintf in einen Puffer formatiert, der blockweise
+ * geschrieben wird. Innerhalb eines Intervalls wird die Ziffernfolge des
+ * Vorgaengers nur hochgezaehlt, die Laufzeit der ausgeschriebenen Form ist
+ * damit linear in der Laenge der Ausgabe. Die Laufzeit der Intervall-Form und
+ * der Vorschau haengt nur von der Anzahl der Intervalle bzw. von limit ab.
+ *
+ * @pre stream ist nicht der Nullzeiger.
+ * @param[in] stream Ausgabestrom.
+ * @param[in] s die Menge.
+ * @param[in] mode die Form.
+ * @param[in] limit Hoechstzahl der ausgeschriebenen Elemente bei SET_PRINT_PREVIEW,
+ *            sonst ohne Bedeutung.
+ */
+void set_print_as (FILE * stream, Set s, SetPrintMode mode, unsigned long limit);
+
 /**
  * Schreibt die Stringrepraesentation der Liste, die zur Implementierung der Menge s 
  * genutzt wird, in den uebergebenen Ausgabestrom.
@@ -236,5 +457,427 @@ void set_print (FILE * stream, Set s);
  */
 void set_print_list (FILE * stream, Set s);
 
+/** Kennung am Anfang einer gespeicherten Menge (siehe set_save) */
+#define SET_FILE_MAGIC "DLS1"
+
+/**
+ * Speichert die Menge s in einem kompakten Binaerformat in stream.
+ *
+ * Nach der Kennung SET_FILE_MAGIC folgen die Anzahl der Intervalle und je
+ * Intervall der Abstand zum vorigen Intervall und die Laenge, jeweils als
+ * Varint (7 Bit je Byte, niederwertige Gruppe zuerst, das oberste Bit zeigt ein
+ * Folgebyte an):
+ * - der Anfang des ersten Intervalls im ZigZag-Code (0, -1, 1, -2, ... als 0, 1, 2, 3, ...),
+ * - bei jedem weiteren Intervall start - voriges Ende - 2 (Intervalle grenzen
+ *   nie aneinander, der Abstand ist also mindestens 2),
+ * - die Laenge als end - start.
+ * Die Groesse haengt damit nur von der Anzahl der Intervalle und der Groesse der
+ * Abstaende ab, nicht von der Anzahl der Elemente.
+ *
+ * @param[in] stream Datei bzw. Stream, in den geschrieben wird.
+ * @param[in] s      die Menge.
+ *
+ * @return 1, falls die Menge geschrieben wurde, 0 bei einem Schreibfehler.
+ *
+ * @pre stream ist nicht der Nullzeiger.
+ */
+int set_save (FILE * stream, Set s);
+
+/**
+ * Liest eine mit set_save gespeicherte Menge aus stream.
+ *
+ * @param[in]  stream Datei bzw. Stream, aus dem gelesen wird.
+ * @param[out] s      die gelesene Menge, bei einem Fehler die leere Menge.
+ *
+ * @return 1, falls die Menge gelesen wurde, 0 falls stream keine gueltige
+ *         gespeicherte Menge enthaelt.
+ *
+ * @pre stream und s sind nicht der Nullzeiger.
+ */
+int set_load (FILE * stream, Set * s);
+
+
+/** Anzahl der Klassen der Haeufigkeitsverteilungen (Zweierpotenzen) */
+#define SET_STATS_BUCKETS 32
+
+/**
+ * Arten von Operationen, denen Allokationen zugerechnet werden.
+ */
+typedef enum SetStatsOp {
+  /** Aufbau mit dem Builder sowie alles ausserhalb der anderen Operationen */
+  SET_STATS_BUILD = 0,
+  /** set_insert und set_insert_range */
+  SET_STATS_INSERT,
+  /** set_remove und set_remove_range */
+  SET_STATS_REMOVE,
+  /** Verknuepfungen (set_merge_build und alle darauf aufbauenden Operationen) */
+  SET_STATS_ALGEBRA,
+  /** Anzahl der Arten */
+  SET_STATS_OPS
+} SetStatsOp;
+
+/**
+ * Zaehler der Speicherverwaltung aller Mengen.
+ *
+ * Eine Haeufigkeitsverteilung zaehlt in Klasse 0 die Anzahl 0 und in Klasse k
+ * die Anzahlen von 2^(k-1) bis 2^k - 1, die letzte Klasse ist nach oben offen.
+ */
+typedef struct {
+  /** Anzahl der Knoten, aktuell und hoechstens */
+  unsigned long liveNodes;
+  unsigned long peakNodes;
+  /** Anzahl der aktuellen Bitmap-Knoten */
+  unsigned long liveBitmaps;
+  /** belegter Speicher fuer Knoten und Bitmaps in Bytes, aktuell und hoechstens */
+  unsigned long bytesInUse;
+  unsigned long peakBytes;
+  /** Anzahl aller Allokationen und Freigaben */
+  unsigned long allocations;
+  unsigned long releases;
+  /** Aufrufe und Allokationen je Art der Operation */
+  unsigned long calls[SET_STATS_OPS];
+  unsigned long allocs[SET_STATS_OPS];
+  /** Verteilung der Knotenanzahl aller aufgebauten Ergebnislisten */
+  unsigned long listLengths[SET_STATS_BUCKETS];
+} SetStats;
+
+/**
+ * Aufbau einer einzelnen Menge.
+ */
+typedef struct {
+  /** Anzahl der Knoten, davon Bitmap-Knoten */
+  unsigned long nodes;
+  unsigned long bitmapNodes;
+  /** Anzahl der Intervalle und Elemente */
+  unsigned long intervals;
+  unsigned long elements;
+  /** durchschnittliche Anzahl der Elemente eines Intervalls */
+  double averageIntervalLength;
+  /** Verteilung der Intervalllaengen */
+  unsigned long intervalLengths[SET_STATS_BUCKETS];
+} SetShape;
+
+/**
+ * Hilfsstruktur zum Aufbau einer Menge aus aufsteigend sortierten Elementen
+ * bzw. Intervallen.
+ *
+ * Da neue Elemente immer nur am Listenende angefuegt werden, kostet jedes
+ * Anfuegen konstante Zeit. Direkt aneinander angrenzende oder sich
+ * ueberschneidende Werte werden dabei sofort zu einem Intervall zusammengefasst.
+ * Die Intervalle des aktuellen Blocks werden gesammelt, bis der Block verlassen
+ * wird, und dann je nach Zersplitterung als Intervalle oder als Bitmap abgelegt.
+ */
+typedef struct {
+  /** Anfang der bisher aufgebauten Liste */
+  Set head;
+  /** letzter Knoten der bisher aufgebauten Liste */
+  Set tail;
+  /** Anzahl der Knoten der bisher aufgebauten Liste */
+  unsigned long nodes;
+  /** Zaehler fuer die Allokationen des Builders, set_builder_init setzt die
+   * globalen Zaehler ein. Eigene Zaehler (z.B. je Thread) werden mit
+   * set_stats_add uebernommen. */
+  SetStats * stats;
+  /** 1, falls das Intervall [runStart, runEnd] noch nicht abgelegt wurde */
+  int running;
+  Element runStart;
+  Element runEnd;
+  /** erstes Element des Blocks, dessen Intervalle gesammelt werden */
+  Element chunkBase;
+  /** Anzahl der gesammelten Intervalle des Blocks */
+  unsigned int count;
+  Element starts[SET_CHUNK_MAX_INTERVALS];
+  Element ends[SET_CHUNK_MAX_INTERVALS];
+  /** Bitmap des Blocks, sobald er zu viele Intervalle enthaelt, sonst NULL */
+  unsigned long * bits;
+  /** kleinstes und groesstes Element der Bitmap */
+  Element bitsMin;
+  Element bitsMax;
+} SetBuilder;
+
+/**
+ * Initialisiert einen Builder mit der leeren Menge.
+ *
+ * @param[out] b der Builder.
+ *
+ * @pre b ist nicht der Nullzeiger.
+ */
+void set_builder_init (SetBuilder * b);
+
+/**
+ * Fuegt ein Element e am Ende der aufzubauenden Menge an.
+ *
+ * @param[in,out] b der Builder.
+ * @param[in]     e das anzufuegende Element.
+ *
+ * @pre b ist nicht der Nullzeiger.
+ * @pre e ist nicht kleiner als das zuletzt angefuegte Element.
+ */
+void set_builder_append (SetBuilder * b, Element e);
+
+/**
+ * Fuegt das Intervall [start, end] am Ende der aufzubauenden Menge an.
+ *
+ * @param[in,out] b     der Builder.
+ * @param[in]     start der Anfang des Intervalls.
+ * @param[in]     end   das Ende des Intervalls.
+ *
+ * @pre b ist nicht der Nullzeiger.
+ * @pre start <= end
+ * @pre start ist nicht kleiner als der Anfang des zuletzt angefuegten Intervalls.
+ */
+void set_builder_append_range (SetBuilder * b, Element start, Element end);
+
+/**
+ * Schliesst den Aufbau ab und liefert die aufgebaute Menge. Der Builder ist
+ * danach wieder leer und kann erneut verwendet werden.
+ *
+ * @param[in,out] b der Builder.
+ *
+ * @return die aufgebaute Menge.
+ *
+ * @pre b ist nicht der Nullzeiger.
+ */
+Set set_builder_finish (SetBuilder * b);
+
+
+/**
+ * Boolesche Verknuepfung zweier Mengen als Wahrheitstabelle.
+ *
+ * Bit (2 * inA + inB) gibt an, ob ein Element, das in a (inA = 1) bzw. b (inB = 1)
+ * enthalten ist, zum Ergebnis gehoert. Bit 0 (in keiner der Mengen) muss stets
+ * 0 sein. Neben den benannten Verknuepfungen ist daher jeder gerade Wert von
+ * 0 bis 14 zulaessig.
+ */
+typedef enum SetOp {
+  /** a oder b */
+  SET_OP_UNION = 0xE,
+  /** a und b */
+  SET_OP_INTERSECTION = 0x8,
+  /** a und nicht b */
+  SET_OP_DIFFERENCE = 0x4,
+  /** b und nicht a */
+  SET_OP_REVERSE_DIFFERENCE = 0x2,
+  /** a oder b, aber nicht beide */
+  SET_OP_SYMMETRIC_DIFFERENCE = 0x6
+} SetOp;
+
+/**
+ * Quelle, die die Intervalle einer Menge aufsteigend sortiert liefert, z.B. aus
+ * einer Intervall-Liste, einem Feld oder einer Datei.
+ */
+typedef struct SetSource {
+  /**
+   * Liefert das naechste Intervall ueber start und end.
+   * Rueckgabe 1, falls ein Intervall geliefert wurde, 0 wenn die Quelle erschoepft ist.
+   */
+  int (*next) (void * state, Element * start, Element * end);
+  /**
+   * Ueberspringt alle Intervalle, die vor e enden, und liefert wie next das
+   * erste verbleibende Intervall. Darf der Nullzeiger sein, dann wird next
+   * wiederholt aufgerufen.
+   */
+  int (*seek) (void * state, Element e, Element * start, Element * end);
+  /** Zustand der Quelle, wird an next und seek uebergeben */
+  void * state;
+} SetSource;
+
+/**
+ * Senke, die die Intervalle eines Ergebnisses aufsteigend sortiert entgegennimmt.
+ * Die gelieferten Intervalle erfuellen die Invarianten der Intervall-Liste.
+ */
+typedef struct SetSink {
+  /** Nimmt das naechste Intervall [start, end] entgegen. */
+  void (*emit) (void * state, Element start, Element end);
+  /** Zustand der Senke, wird an emit uebergeben */
+  void * state;
+} SetSink;
+
+/**
+ * Leseposition in einer Liste, Zustand einer Listen-Quelle.
+ */
+typedef struct {
+  /** aktueller Knoten */
+  Set node;
+  /** naechstes zu lesendes Element im aktuellen Knoten */
+  Element pos;
+  /** Knoten, an dem das Lesen endet (EMPTY_SET fuer das Listenende) */
+  Set stop;
+} SetListCursor;
+
+/**
+ * Erzeugt eine Quelle, die die Intervalle einer Liste liefert. Bitmap-Knoten
+ * werden dabei in Intervalle zerlegt, an Knotengrenzen angrenzende Intervalle
+ * zusammengefasst.
+ *
+ * @param[out] cursor Leseposition, wird von der Quelle verwendet.
+ * @param[in]  s      die Menge.
+ *
+ * @return die Quelle.
+ *
+ * @pre cursor ist nicht der Nullzeiger.
+ */
+SetSource set_source_list (SetListCursor * cursor, Set s);
+
+/**
+ * Erzeugt eine Senke, die alle Intervalle an einen Builder anhaengt.
+ *
+ * @param[in,out] b der Builder.
+ *
+ * @return die Senke.
+ *
+ * @pre b ist nicht der Nullzeiger.
+ */
+SetSink set_sink_builder (SetBuilder * b);
+
+/**
+ * Verknuepft die Intervalle zweier Quellen gemaess op und gibt das Ergebnis an
+ * die Senke out weiter.
+ *
+ * Die Intervallgrenzen beider Quellen werden in einem gemeinsamen Durchlauf
+ * abgearbeitet. Zwischen zwei Grenzen aendert sich die Zugehoerigkeit zu a und b
+ * nicht, so dass jedes Stueck mit einem Tabellenzugriff in op entschieden wird.
+ * Traegt eine Menge allein nichts zum Ergebnis bei (z.B. beim Schnitt), werden
+ * ihre Intervalle bis zum naechsten Intervall der anderen Menge mittels seek
+ * uebersprungen.
+ *
+ * @param[in,out] a   Quelle der ersten Menge.
+ * @param[in,out] b   Quelle der zweiten Menge.
+ * @param[in]     op  die Verknuepfung.
+ * @param[in,out] out die Senke.
+ *
+ * @pre a, b und out sind nicht der Nullzeiger.
+ */
+void set_merge (SetSource * a, SetSource * b, SetOp op, SetSink * out);
+
+/**
+ * Verknuepft die Intervalle zweier Quellen gemaess op (siehe set_merge) und
+ * liefert das Ergebnis als neue Menge.
+ *
+ * @param[in,out] a  Quelle der ersten Menge.
+ * @param[in,out] b  Quelle der zweiten Menge.
+ * @param[in]     op die Verknuepfung.
+ *
+ * @return die verknuepfte Menge.
+ *
+ * @pre a und b sind nicht der Nullzeiger.
+ */
+Set set_merge_build (SetSource * a, SetSource * b, SetOp op);
+
+/**
+ * Erzeugt die Verknuepfung der beiden Mengen a und b gemaess op als neue Menge.
+ *
+ * Die beiden Mengen a und b bleiben hierbei unveraendert.
+ *
+ * @param[in] a  die erste Menge.
+ * @param[in] b  die zweite Menge.
+ * @param[in] op die Verknuepfung.
+ *
+ * @return die verknuepfte Menge.
+ */
+Set set_combine (Set a, Set b, SetOp op);
+
+/**
+ * Verknuepft die Intervalle von count Quellen und gibt das Ergebnis an die
+ * Senke out weiter. Zulaessig sind nur SET_OP_UNION und SET_OP_INTERSECTION.
+ *
+ * Die aktuellen Intervalle aller Quellen liegen in einem Heap, bei der
+ * Vereinigung nach ihrem Anfang, beim Schnitt nach ihrem Ende geordnet. Die
+ * Vereinigung entnimmt jeweils das Intervall mit dem kleinsten Anfang und fasst
+ * es mit dem laufenden Ergebnisintervall zusammen. Der Schnitt fuehrt den
+ * groessten Anfang aller aktuellen Intervalle mit: Endet das Intervall an der
+ * Spitze des Heaps nicht davor, liegt das Stueck dazwischen in allen Quellen,
+ * sonst wird seine Quelle per seek bis dorthin vorgesetzt. Bei insgesamt n
+ * Intervallen kostet beides O(n * log(count)).
+ *
+ * @param[in,out] sources die Quellen.
+ * @param[in]     count   Anzahl der Quellen.
+ * @param[in]     op      SET_OP_UNION oder SET_OP_INTERSECTION.
+ * @param[in,out] out     die Senke.
+ *
+ * @pre sources ist nicht der Nullzeiger oder count ist 0.
+ * @pre out ist nicht der Nullzeiger.
+ */
+void set_merge_all (SetSource * sources, unsigned long count, SetOp op, SetSink * out);
+
+/**
+ * Erzeugt die Verknuepfung der count Mengen sets[0] bis sets[count - 1]
+ * gemaess op (siehe set_merge_all) als neue Menge.
+ *
+ * Die Mengen bleiben hierbei unveraendert.
+ *
+ * @param[in] sets  die Mengen.
+ * @param[in] count Anzahl der Mengen.
+ * @param[in] op    SET_OP_UNION oder SET_OP_INTERSECTION.
+ *
+ * @return die verknuepfte Menge, die leere Menge bei count 0.
+ *
+ * @pre sets ist nicht der Nullzeiger oder count ist 0.
+ */
+Set set_combine_all (const Set * sets, unsigned long count, SetOp op);
+
+
+/**
+ * Liefert den aktuellen Stand der Zaehler.
+ *
+ * @param[out] stats die Zaehler.
+ *
+ * @pre stats ist nicht der Nullzeiger.
+ */
+void set_stats_get (SetStats * stats);
+
+/**
+ * Uebernimmt separat gesammelte Zaehler (siehe SetBuilder) in die globalen
+ * Zaehler. Alle Allokationen werden dabei der Operation op zugerechnet, die
+ * als einmal aufgerufen gezaehlt wird.
+ *
+ * @param[in] local die separat gesammelten Zaehler.
+ * @param[in] op    die Operation.
+ *
+ * @pre local ist nicht der Nullzeiger.
+ */
+void set_stats_add (const SetStats * local, SetStatsOp op);
+
+/**
+ * Setzt alle Zaehler zurueck. Die aktuelle Belegung bleibt erhalten und ist
+ * danach zugleich die hoechste Belegung.
+ */
+void set_stats_reset (void);
+
+/**
+ * Ermittelt den Aufbau der Menge s.
+ *
+ * Die Menge s bleibt hierbei unveraendert.
+ *
+ * @param[in]  s     die Menge.
+ * @param[out] shape der Aufbau.
+ *
+ * @pre shape ist nicht der Nullzeiger.
+ */
+void set_stats_shape (Set s, SetShape * shape);
+
+/**
+ * Schreibt die Zaehler maschinenlesbar als Zeilen "stats.name=wert" in den
+ * uebergebenen Ausgabestrom. Von den Verteilungen werden nur die belegten
+ * Klassen als "name.untergrenze=anzahl" ausgegeben.
+ *
+ * @param[in] stream Ausgabestrom.
+ * @param[in] stats  die Zaehler.
+ *
+ * @pre stream und stats sind nicht der Nullzeiger.
+ */
+void set_stats_print (FILE * stream, const SetStats * stats);
+
+/**
+ * Schreibt den Aufbau einer Menge maschinenlesbar als Zeilen "shape.name=wert"
+ * in den uebergebenen Ausgabestrom.
+ *
+ * @param[in] stream Ausgabestrom.
+ * @param[in] shape  der Aufbau.
+ *
+ * @pre stream und shape sind nicht der Nullzeiger.
+ */
+void set_stats_print_shape (FILE * stream, const SetShape * shape);
+
 
 #endif
@@ -0,0 +1,290 @@
+/**
+ * @file setconcurrent.c Implementierung einer Menge mit sperrfreien Lesern.
+ *
+ * @author alexander loeffler, andre kloodt
+ */
+
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "setconcurrent.h"
+#include "error.h"
+
+#ifndef __GNUC__
+/* ersetzt die atomaren Zugriffe, wenn keine atomaren Builtins verfuegbar sind */
+static pthread_mutex_t atomicLock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+
+/**
+ * Liest eine Version atomar.
+ *
+ * @param[in] p Adresse der Version.
+ *
+ * @return die Version.
+ */
+static Set
+loadSet (Set * p) {
+#ifdef __GNUC__
+    return __atomic_load_n(p, __ATOMIC_SEQ_CST);
+#else
+    Set s = EMPTY_SET;
+
+    pthread_mutex_lock(&atomicLock);
+    s = *p;
+    pthread_mutex_unlock(&atomicLock);
+    return s;
+#endif
+}
+
+/**
+ * Schreibt eine Version atomar.
+ *
+ * @param[out] p Adresse der Version.
+ * @param[in]  s die Version.
+ */
+static void
+storeSet (Set * p, Set s) {
+#ifdef __GNUC__
+    __atomic_store_n(p, s, __ATOMIC_SEQ_CST);
+#else
+    pthread_mutex_lock(&atomicLock);
+    *p = s;
+    pthread_mutex_unlock(&atomicLock);
+#endif
+}
+
+/**
+ * Liest eine Epoche atomar.
+ *
+ * @param[in] p Adresse der Epoche.
+ *
+ * @return die Epoche.
+ */
+static unsigned long
+loadEpoch (unsigned long * p) {
+#ifdef __GNUC__
+    return __atomic_load_n(p, __ATOMIC_SEQ_CST);
+#else
+    unsigned long epoch = 0;
+
+    pthread_mutex_lock(&atomicLock);
+    epoch = *p;
+    pthread_mutex_unlock(&atomicLock);
+    return epoch;
+#endif
+}
+
+/**
+ * Schreibt eine Epoche atomar.
+ *
+ * @param[out] p     Adresse der Epoche.
+ * @param[in]  epoch die Epoche.
+ */
+static void
+storeEpoch (unsigned long * p, unsigned long epoch) {
+#ifdef __GNUC__
+    __atomic_store_n(p, epoch, __ATOMIC_SEQ_CST);
+#else
+    pthread_mutex_lock(&atomicLock);
+    *p = epoch;
+    pthread_mutex_unlock(&atomicLock);
+#endif
+}
+
+/**
+ * Belegt einen freien Platz atomar.
+ *
+ * @param[in,out] used Belegung des Platzes.
+ *
+ * @return 1, falls der Platz frei war und nun belegt ist, sonst 0.
+ */
+static int
+claimSlot (int * used) {
+#ifdef __GNUC__
+    int expected = 0;
+
+    return __atomic_compare_exchange_n(used, &expected, 1, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+#else
+    int claimed = 0;
+
+    pthread_mutex_lock(&atomicLock);
+    claimed = *used == 0;
+    *used = 1;
+    pthread_mutex_unlock(&atomicLock);
+    return claimed;
+#endif
+}
+
+/**
+ * Gibt alle abgeloesten Versionen frei, die vor dem Beginn des aeltesten
+ * laufenden Lesevorgangs abgeloest wurden.
+ *
+ * @param[in,out] c die Menge.
+ */
+static void
+reclaim (SetConcurrent * c) {
+    SetRetired ** link = &c->retired;
+    SetRetired * r = NULL;
+    unsigned long oldest = c->epoch;
+    unsigned long epoch = 0;
+    int i = 0;
+
+    for(i = 0; i < SETCONCURRENT_MAX_READERS; i++){
+        epoch = loadEpoch(&c->readers[i].epoch);
+        if (epoch != 0 && epoch < oldest) {
+            oldest = epoch;
+        }
+    }
+
+    while(*link != NULL){
+        r = *link;
+        if (r->epoch < oldest) {
+            *link = r->next;
+            r->set = set_clear(r->set);
+            free(r);
+        } else {
+            link = &r->next;
+        }
+    }
+}
+
+
+void
+setconcurrent_init (SetConcurrent * c, Set s) {
+    int i = 0;
+
+    assert(c != NULL);
+
+    for(i = 0; i < SETCONCURRENT_MAX_READERS; i++){
+        c->readers[i].epoch = 0;
+        c->readers[i].used = 0;
+    }
+    c->current = s;
+    c->epoch = 1;
+    c->retired = NULL;
+    pthread_mutex_init(&c->writer, NULL);
+}
+
+
+void
+setconcurrent_destroy (SetConcurrent * c) {
+    SetRetired * r = NULL;
+
+    assert(c != NULL);
+
+    while(c->retired != NULL){
+        r = c->retired;
+        c->retired = r->next;
+        r->set = set_clear(r->set);
+        free(r);
+    }
+    c->current = set_clear(c->current);
+    pthread_mutex_destroy(&c->writer);
+}
+
+
+int
+setconcurrent_register (SetConcurrent * c) {
+    int i = 0;
+
+    assert(c != NULL);
+
+    for(i = 0; i < SETCONCURRENT_MAX_READERS; i++){
+        if (claimSlot(&c->readers[i].used)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+
+void
+setconcurrent_unregister (SetConcurrent * c, int reader) {
+    assert(c != NULL);
+    assert(reader >= 0 && reader < SETCONCURRENT_MAX_READERS);
+
+    storeEpoch(&c->readers[reader].epoch, 0);
+#ifdef __GNUC__
+    __atomic_store_n(&c->readers[reader].used, 0, __ATOMIC_SEQ_CST);
+#else
+    pthread_mutex_lock(&atomicLock);
+    c->readers[reader].used = 0;
+    pthread_mutex_unlock(&atomicLock);
+#endif
+}
+
+
+Set
+setconcurrent_read_begin (SetConcurrent * c, int reader) {
+    assert(c != NULL);
+    assert(reader >= 0 && reader < SETCONCURRENT_MAX_READERS);
+
+    /* erst die Epoche ankuendigen, dann die Version lesen: eine danach
+     * abgeloeste Version wird nicht freigegeben, solange der Platz belegt ist */
+    storeEpoch(&c->readers[reader].epoch, loadEpoch(&c->epoch));
+    return loadSet(&c->current);
+}
+
+
+void
+setconcurrent_read_end (SetConcurrent * c, int reader) {
+    assert(c != NULL);
+    assert(reader >= 0 && reader < SETCONCURRENT_MAX_READERS);
+
+    storeEpoch(&c->readers[reader].epoch, 0);
+}
+
+
+int
+setconcurrent_contains (SetConcurrent * c, int reader, Element e) {
+    int result = set_contains(setconcurrent_read_begin(c, reader), e);
+
+    setconcurrent_read_end(c, reader);
+    return result;
+}
+
+
+Set
+setconcurrent_edit_begin (SetConcurrent * c) {
+    assert(c != NULL);
+
+    pthread_mutex_lock(&c->writer);
+    return set_copy(c->current);
+}
+
+
+void
+setconcurrent_edit_commit (SetConcurrent * c, Set next) {
+    SetRetired * r = NULL;
+
+    assert(c != NULL);
+
+    r = malloc(sizeof(SetRetired));
+    if (r == NULL) {
+        exit(ERR_OUT_OF_MEMORY);
+    }
+    r->set = c->current;
+    r->epoch = c->epoch;
+    r->next = c->retired;
+    c->retired = r;
+
+    storeSet(&c->current, next);
+    storeEpoch(&c->epoch, c->epoch + 1);
+    reclaim(c);
+
+    pthread_mutex_unlock(&c->writer);
+}
+
+
+void
+setconcurrent_insert (SetConcurrent * c, Element e) {
+    setconcurrent_edit_commit(c, set_insert(setconcurrent_edit_begin(c), e));
+}
+
+
+void
+setconcurrent_remove (SetConcurrent * c, Element e) {
+    setconcurrent_edit_commit(c, set_remove(setconcurrent_edit_begin(c), e));
+}
@@ -0,0 +1,208 @@
+#ifndef __SETCONCURRENT_H__
+#define __SETCONCURRENT_H__
+
+/**
+ * @file setconcurrent.h Schnittstelle einer Menge, die von vielen Threads ohne
+ * Sperren gelesen und von einem Thread veraendert wird.
+ *
+ * Die Menge wird in Versionen veroeffentlicht: Der schreibende Thread erhaelt
+ * mit setconcurrent_edit_begin eine Kopie der aktuellen Version (set_copy, die
+ * Knoten werden also gemeinsam genutzt) und veraendert sie mit den ueblichen
+ * Funktionen aus set.h. Da gemeinsam genutzte Knoten dabei kopiert statt
+ * veraendert werden, bleibt die veroeffentlichte Version unberuehrt.
+ * setconcurrent_edit_commit veroeffentlicht die neue Version atomar.
+ *
+ * Lesende Threads kuendigen ihren Lesevorgang mit der aktuellen Epoche in einem
+ * eigenen Platz an und lesen die veroeffentlichte Version ohne Sperre. Eine
+ * abgeloeste Version wird erst freigegeben, wenn kein Lesevorgang mehr aktiv
+ * ist, der vor ihrer Abloesung begonnen hat (epochenbasierte Freigabe). Die
+ * Referenzzaehler der Knoten werden nur vom schreibenden Thread veraendert.
+ *
+ * Jede Veroeffentlichung kopiert die Knoten bis zur letzten Aenderung, mehrere
+ * Aenderungen sollten daher zwischen edit_begin und edit_commit gebuendelt werden.
+ *
+ * Ohne GCC-kompatiblen Compiler (atomare Builtins) werden die atomaren
+ * Zugriffe durch eine Sperre ersetzt, die Leser sind dann nicht mehr sperrfrei.
+ *
+ * @author alexander loeffler, andre kloodt
+ */
+
+#include <pthread.h>
+
+#include "set.h"
+
+/** Hoechstzahl gleichzeitig angemeldeter lesender Threads */
+#ifndef SETCONCURRENT_MAX_READERS
+#define SETCONCURRENT_MAX_READERS 64
+#endif
+
+/** Groesse einer Cache-Zeile, jeder Leser erhaelt eine eigene */
+#ifndef SETCONCURRENT_CACHE_LINE
+#define SETCONCURRENT_CACHE_LINE 64
+#endif
+
+/**
+ * Platz eines lesenden Threads.
+ */
+typedef struct {
+  /** angekuendigte Epoche des laufenden Lesevorgangs, 0 ausserhalb */
+  unsigned long epoch;
+  /** 1, falls der Platz an einen Thread vergeben ist */
+  int used;
+  /** Auffuellung, damit sich Leser keine Cache-Zeile teilen */
+  char padding[SETCONCURRENT_CACHE_LINE - sizeof(unsigned long) - sizeof(int)];
+} SetReaderSlot;
+
+/**
+ * Abgeloeste Version, die noch nicht freigegeben werden konnte.
+ */
+typedef struct SetRetired {
+  /** die Version */
+  Set set;
+  /** Epoche, in der die Version abgeloest wurde */
+  unsigned long epoch;
+  /** naechste abgeloeste Version */
+  struct SetRetired * next;
+} SetRetired;
+
+/**
+ * Menge mit sperrfreien Lesern und einem schreibenden Thread.
+ */
+typedef struct {
+  /** Plaetze der lesenden Threads */
+  SetReaderSlot readers[SETCONCURRENT_MAX_READERS];
+  /** die veroeffentlichte Version */
+  Set current;
+  /** aktuelle Epoche, beginnt bei 1 */
+  unsigned long epoch;
+  /** abgeloeste, noch nicht freigegebene Versionen */
+  SetRetired * retired;
+  /** Sperre fuer schreibende Threads */
+  pthread_mutex_t writer;
+} SetConcurrent;
+
+/**
+ * Initialisiert eine nebenlaeufige Menge mit s als erster Version.
+ *
+ * @param[out] c die Menge.
+ * @param[in]  s die erste Version, gehoert danach c.
+ *
+ * @pre c ist nicht der Nullzeiger.
+ */
+void setconcurrent_init (SetConcurrent * c, Set s);
+
+/**
+ * Gibt alle Versionen einer nebenlaeufigen Menge frei.
+ *
+ * @param[in,out] c die Menge.
+ *
+ * @pre c ist nicht der Nullzeiger.
+ * @pre kein Thread liest oder veraendert die Menge.
+ */
+void setconcurrent_destroy (SetConcurrent * c);
+
+/**
+ * Meldet einen lesenden Thread an.
+ *
+ * @param[in,out] c die Menge.
+ *
+ * @return Nummer des Platzes des Threads oder -1, falls bereits
+ *         SETCONCURRENT_MAX_READERS Threads angemeldet sind.
+ *
+ * @pre c ist nicht der Nullzeiger.
+ */
+int setconcurrent_register (SetConcurrent * c);
+
+/**
+ * Meldet einen lesenden Thread ab.
+ *
+ * @param[in,out] c      die Menge.
+ * @param[in]     reader Nummer des Platzes (von setconcurrent_register).
+ *
+ * @pre c ist nicht der Nullzeiger.
+ * @pre der Thread liest gerade nicht.
+ */
+void setconcurrent_unregister (SetConcurrent * c, int reader);
+
+/**
+ * Beginnt einen Lesevorgang und liefert die veroeffentlichte Version. Sie
+ * bleibt bis setconcurrent_read_end gueltig und darf nur mit nicht
+ * veraendernden Funktionen (z.B. set_contains, set_source_list) gelesen werden.
+ *
+ * @param[in,out] c      die Menge.
+ * @param[in]     reader Nummer des Platzes des Threads.
+ *
+ * @return die veroeffentlichte Version.
+ *
+ * @pre c ist nicht der Nullzeiger.
+ */
+Set setconcurrent_read_begin (SetConcurrent * c, int reader);
+
+/**
+ * Beendet einen Lesevorgang.
+ *
+ * @param[in,out] c      die Menge.
+ * @param[in]     reader Nummer des Platzes des Threads.
+ *
+ * @pre c ist nicht der Nullzeiger.
+ */
+void setconcurrent_read_end (SetConcurrent * c, int reader);
+
+/**
+ * Prueft in einem eigenen Lesevorgang, ob ein Element enthalten ist.
+ *
+ * @param[in,out] c      die Menge.
+ * @param[in]     reader Nummer des Platzes des Threads.
+ * @param[in]     e      das zu pruefende Element.
+ *
+ * @return 1, falls Element enthalten ist, sonst 0.
+ *
+ * @pre c ist nicht der Nullzeiger.
+ */
+int setconcurrent_contains (SetConcurrent * c, int reader, Element e);
+
+/**
+ * Beginnt eine Aenderung und liefert eine Kopie der veroeffentlichten Version,
+ * die mit den Funktionen aus set.h veraendert werden darf. Bis zu
+ * setconcurrent_edit_commit sind andere schreibende Threads gesperrt.
+ *
+ * @param[in,out] c die Menge.
+ *
+ * @return Kopie der veroeffentlichten Version.
+ *
+ * @pre c ist nicht der Nullzeiger.
+ */
+Set setconcurrent_edit_begin (SetConcurrent * c);
+
+/**
+ * Veroeffentlicht eine mit setconcurrent_edit_begin begonnene Aenderung und
+ * gibt abgeloeste Versionen frei, die kein Leser mehr verwendet.
+ *
+ * @param[in,out] c    die Menge.
+ * @param[in]     next die neue Version, gehoert danach c.
+ *
+ * @pre c ist nicht der Nullzeiger.
+ */
+void setconcurrent_edit_commit (SetConcurrent * c, Set next);
+
+/**
+ * Fuegt ein Element ein und veroeffentlicht die neue Version.
+ *
+ * @param[in,out] c die Menge.
+ * @param[in]     e das Element.
+ *
+ * @pre c ist nicht der Nullzeiger.
+ */
+void setconcurrent_insert (SetConcurrent * c, Element e);
+
+/**
+ * Entfernt ein Element und veroeffentlicht die neue Version.
+ *
+ * @param[in,out] c die Menge.
+ * @param[in]     e das Element.
+ *
+ * @pre c ist nicht der Nullzeiger.
+ */
+void setconcurrent_remove (SetConcurrent * c, Element e);
+
+#endif
@@ -0,0 +1,427 @@
+/**
+ * @file setindex.c Implementierung eines Feld-basierten Index fuer Intervall-Listen.
+ *
+ * @author alexander loeffler, andre kloodt
+ */
+
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <limits.h>
+
+#include "setindex.h"
+#include "error.h"
+
+/** Anzahl der Intervalle, die vor dem Galoppieren linear geprueft werden */
+#define SETINDEX_LINEAR_STEPS 4
+
+/** Abstand, in dem die Eytzinger-Suche vorab laedt: 16 Nachfahren vier Ebenen tiefer */
+#define SETINDEX_PREFETCH_NODES 16
+
+
+SetIndex
+setindex_create (Set s) {
+    SetIndex idx;
+    SetListCursor cursor;
+    SetSource src = set_source_list(&cursor, s);
+    Element start = 0, end = 0;
+    unsigned long i = 0;
+
+    idx.starts = NULL;
+    idx.ends = NULL;
+    idx.below = NULL;
+    idx.count = 0;
+    idx.tree = NULL;
+    idx.treeStarts = NULL;
+    idx.treePos = NULL;
+
+    while(src.next(src.state, &start, &end)){
+        idx.count++;
+    }
+
+    idx.below = malloc((idx.count + 1) * sizeof(unsigned long));
+    if (idx.below == NULL) {
+        exit(ERR_OUT_OF_MEMORY);
+    }
+    if (idx.count > 0) {
+        idx.starts = malloc(idx.count * sizeof(Element));
+        idx.ends = malloc(idx.count * sizeof(Element));
+        if (idx.starts == NULL || idx.ends == NULL) {
+            exit(ERR_OUT_OF_MEMORY);
+        }
+    }
+
+    idx.below[0] = 0;
+    src = set_source_list(&cursor, s);
+    while(src.next(src.state, &start, &end)){
+        idx.starts[i] = start;
+        idx.ends[i] = end;
+        idx.below[i + 1] = idx.below[i] + ((unsigned long) end - (unsigned long) start + 1);
+        i++;
+    }
+
+    return idx;
+}
+
+
+void
+setindex_delete (SetIndex * idx) {
+    assert(idx != NULL);
+
+    free(idx->starts);
+    free(idx->ends);
+    free(idx->below);
+    free(idx->tree);
+    free(idx->treeStarts);
+    free(idx->treePos);
+    idx->starts = NULL;
+    idx->ends = NULL;
+    idx->below = NULL;
+    idx->tree = NULL;
+    idx->treeStarts = NULL;
+    idx->treePos = NULL;
+    idx->count = 0;
+}
+
+/**
+ * Belegt den Teilbaum ab Knoten k der Eytzinger-Anordnung in symmetrischer
+ * Reihenfolge mit den Intervallen ab Position pos.
+ *
+ * @param[in,out] idx der Index.
+ * @param[in]     k   Knoten (ab 1).
+ * @param[in]     pos Position des ersten noch nicht abgelegten Intervalls.
+ *
+ * @return Position des ersten danach noch nicht abgelegten Intervalls.
+ */
+static unsigned long
+fillTree (SetIndex * idx, unsigned long k, unsigned long pos) {
+    if (k <= idx->count) {
+        pos = fillTree(idx, 2 * k, pos);
+        idx->tree[k] = idx->ends[pos];
+        idx->treeStarts[k] = idx->starts[pos];
+        idx->treePos[k] = pos;
+        pos = fillTree(idx, 2 * k + 1, pos + 1);
+    }
+    return pos;
+}
+
+
+void
+setindex_eytzinger (SetIndex * idx) {
+    assert(idx != NULL);
+
+    if (idx->tree != NULL) {
+        return;
+    }
+
+    idx->tree = malloc((idx->count + 1) * sizeof(Element));
+    idx->treeStarts = malloc((idx->count + 1) * sizeof(Element));
+    idx->treePos = malloc((idx->count + 1) * sizeof(unsigned long));
+    if (idx->tree == NULL || idx->treeStarts == NULL || idx->treePos == NULL) {
+        exit(ERR_OUT_OF_MEMORY);
+    }
+    idx->tree[0] = 0;
+    idx->treeStarts[0] = 0;
+    idx->treePos[0] = idx->count;
+    fillTree(idx, 1, 0);
+}
+
+/**
+ * Sucht ueber die Eytzinger-Anordnung das erste Intervall, das nicht vor dem
+ * Element e endet.
+ *
+ * Der Abstieg waehlt das Kind ohne Verzweigung (k = 2k + (tree[k] < e)). Am
+ * Ende ist k ein Knoten hinter dem letzten Blatt, die abschliessenden 1-Bits
+ * von k sind die Abstiege nach rechts nach dem letzten Abstieg nach links, der
+ * zum Ergebnis fuehrte. Ohne solchen Abstieg ergibt sich Knoten 0.
+ *
+ * @param[in] idx der Index (mit Eytzinger-Anordnung).
+ * @param[in] e   das Element.
+ *
+ * @return Knoten des Intervalls bzw. 0, falls alle Intervalle vor e enden.
+ */
+static unsigned long
+findTree (const SetIndex * idx, Element e) {
+    const Element * tree = idx->tree;
+    unsigned long n = idx->count;
+    unsigned long k = 1;
+
+    while(k <= n){
+#ifdef __GNUC__
+        __builtin_prefetch(tree + SETINDEX_PREFETCH_NODES * k);
+#endif
+        k = 2 * k + (unsigned long) (tree[k] < e);
+    }
+
+#ifdef __GNUC__
+    k >>= __builtin_ctzl(~k) + 1;
+#else
+    while(k & 1UL){
+        k >>= 1;
+    }
+    k >>= 1;
+#endif
+
+    return k;
+}
+
+/**
+ * Sucht binaer das erste Intervall, das nicht vor dem Element e endet. Besitzt
+ * der Index eine Eytzinger-Anordnung, wird stattdessen diese durchsucht.
+ *
+ * @param[in] idx der Index.
+ * @param[in] e   das Element.
+ *
+ * @return Position des Intervalls bzw. idx->count, falls alle Intervalle vor e enden.
+ */
+static unsigned long
+findIntervall (const SetIndex * idx, Element e) {
+    unsigned long lo = 0;
+    unsigned long hi = idx->count;
+    unsigned long mid = 0;
+
+    if (idx->tree != NULL) {
+        return idx->treePos[findTree(idx, e)];
+    }
+
+    while(lo < hi){
+        mid = lo + (hi - lo) / 2;
+        if (idx->ends[mid] < e) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+
+unsigned long
+setindex_gallop (const SetIndex * idx, unsigned long from, Element e) {
+    unsigned long lo = from;
+    unsigned long hi = 0;
+    unsigned long step = 1;
+    unsigned long mid = 0;
+    int i = 0;
+
+    assert(idx != NULL);
+    assert(from <= idx->count);
+
+    /* die naechsten Intervalle linear pruefen (ausgeglichene Mengen) */
+    for(i = 0; i < SETINDEX_LINEAR_STEPS && lo < idx->count; i++){
+        if (idx->ends[lo] >= e) {
+            return lo;
+        }
+        lo++;
+    }
+
+    /* galoppieren, bis ein Intervall hinter e endet, alle Positionen vor lo
+     * enden dabei stets vor e */
+    hi = lo;
+    while(hi < idx->count && idx->ends[hi] < e){
+        lo = hi + 1;
+        hi = lo + step;
+        step *= 2;
+    }
+    if (hi > idx->count) {
+        hi = idx->count;
+    }
+
+    /* binaere Suche in [lo, hi] */
+    while(lo < hi){
+        mid = lo + (hi - lo) / 2;
+        if (idx->ends[mid] < e) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    return lo;
+}
+
+
+unsigned long
+setindex_lower_bound (const SetIndex * idx, Element e) {
+    assert(idx != NULL);
+
+    return findIntervall(idx, e);
+}
+
+
+int
+setindex_contains (const SetIndex * idx, Element e) {
+    unsigned long i = 0;
+
+    assert(idx != NULL);
+
+    if (idx->tree != NULL) {
+        /* Anfang direkt aus der Eytzinger-Anordnung, ohne Umweg ueber die Position */
+        i = findTree(idx, e);
+        return i != 0 && idx->treeStarts[i] <= e;
+    }
+
+    i = findIntervall(idx, e);
+    return i < idx->count && idx->starts[i] <= e;
+}
+
+
+unsigned long
+setindex_cardinality (const SetIndex * idx) {
+    assert(idx != NULL);
+
+    return idx->below[idx->count];
+}
+
+
+unsigned long
+setindex_rank (const SetIndex * idx, Element e) {
+    unsigned long i = 0;
+
+    assert(idx != NULL);
+
+    i = findIntervall(idx, e);
+    if (i < idx->count && idx->starts[i] < e) {
+        return idx->below[i] + ((unsigned long) e - (unsigned long) idx->starts[i]);
+    }
+    return idx->below[i];
+}
+
+
+int
+setindex_select (const SetIndex * idx, unsigned long k, Element * e) {
+    unsigned long lo = 0;
+    unsigned long hi = 0;
+    unsigned long mid = 0;
+    unsigned long offset = 0;
+
+    assert(idx != NULL);
+    assert(e != NULL);
+
+    if (k >= idx->below[idx->count]) {
+        return 0;
+    }
+
+    /* letztes Intervall, vor dem hoechstens k Elemente liegen */
+    hi = idx->count - 1;
+    while(lo < hi){
+        mid = lo + (hi - lo) / 2;
+        if (idx->below[mid + 1] <= k) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    /* der Abstand zum Anfang kann bei sehr langen Intervallen LONG_MAX uebersteigen */
+    offset = k - idx->below[lo];
+    *e = idx->starts[lo];
+    if (offset > (unsigned long) LONG_MAX) {
+        *e += LONG_MAX;
+        offset -= (unsigned long) LONG_MAX;
+    }
+    *e += (Element) offset;
+    return 1;
+}
+
+
+unsigned long
+setindex_count_range (const SetIndex * idx, Element a, Element b) {
+    unsigned long i = 0;
+    unsigned long upTo = 0;
+
+    assert(idx != NULL);
+
+    if (a > b) {
+        return 0;
+    }
+
+    /* Anzahl der Elemente <= b */
+    i = findIntervall(idx, b);
+    upTo = idx->below[i];
+    if (i < idx->count && idx->starts[i] <= b) {
+        upTo += (unsigned long) b - (unsigned long) idx->starts[i] + 1;
+    }
+
+    return upTo - setindex_rank(idx, a);
+}
+
+
+/**
+ * Liefert das naechste Intervall einer Index-Quelle.
+ *
+ * @param[in,out] state die Leseposition (SetIndexCursor).
+ * @param[out]    start Anfang des Intervalls.
+ * @param[out]    end   Ende des Intervalls.
+ *
+ * @return 1, falls ein Intervall geliefert wurde, 0 wenn der Index erschoepft ist.
+ */
+static int
+indexSourceNext (void * state, Element * start, Element * end) {
+    SetIndexCursor * cursor = state;
+
+    if (cursor->pos >= cursor->idx->count) {
+        return 0;
+    }
+    *start = cursor->idx->starts[cursor->pos];
+    *end = cursor->idx->ends[cursor->pos];
+    cursor->pos++;
+    return 1;
+}
+
+/**
+ * Springt in einer Index-Quelle galoppierend zum ersten Intervall, das nicht
+ * vor e endet, und liefert es.
+ *
+ * @param[in,out] state die Leseposition (SetIndexCursor).
+ * @param[in]     e     das Element.
+ * @param[out]    start Anfang des Intervalls.
+ * @param[out]    end   Ende des Intervalls.
+ *
+ * @return 1, falls ein Intervall geliefert wurde, 0 wenn der Index erschoepft ist.
+ */
+static int
+indexSourceSeek (void * state, Element e, Element * start, Element * end) {
+    SetIndexCursor * cursor = state;
+
+    cursor->pos = setindex_gallop(cursor->idx, cursor->pos, e);
+    return indexSourceNext(state, start, end);
+}
+
+
+SetSource
+setindex_source (SetIndexCursor * cursor, const SetIndex * idx) {
+    SetSource src;
+
+    assert(cursor != NULL);
+    assert(idx != NULL);
+
+    cursor->idx = idx;
+    cursor->pos = 0;
+    src.next = indexSourceNext;
+    src.seek = indexSourceSeek;
+    src.state = cursor;
+    return src;
+}
+
+
+Set
+setindex_intersection (Set a, const SetIndex * b) {
+    SetListCursor cursorA;
+    SetIndexCursor cursor;
+    SetSource srcA = set_source_list(&cursorA, a);
+    SetSource srcB = setindex_source(&cursor, b);
+
+    return set_merge_build(&srcA, &srcB, SET_OP_INTERSECTION);
+}
+
+
+Set
+setindex_difference (Set a, const SetIndex * b) {
+    SetListCursor cursorA;
+    SetIndexCursor cursor;
+    SetSource srcA = set_source_list(&cursorA, a);
+    SetSource srcB = setindex_source(&cursor, b);
+
+    return set_merge_build(&srcA, &srcB, SET_OP_DIFFERENCE);
+}
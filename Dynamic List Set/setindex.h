@@ -0,0 +1,244 @@
+#ifndef __SETINDEX_H__
+#define __SETINDEX_H__
+
+/**
+ * @file setindex.h Schnittstelle eines Feld-basierten Index fuer Intervall-Listen.
+ *
+ * Ein Index ist eine unveraenderliche Kopie einer Menge, deren Intervallgrenzen in
+ * zwei zusammenhaengenden Feldern (Anfaenge und Enden) aufsteigend sortiert abgelegt
+ * sind. Im Gegensatz zur Liste erlaubt der Index wahlfreien Zugriff, so dass Intervalle
+ * per binaerer bzw. exponentieller (galoppierender) Suche gefunden werden koennen.
+ *
+ * Der Index lohnt sich fuer grosse Mengen, die selten veraendert, aber haeufig mit
+ * kleinen Mengen verknuepft werden: Schnitt und Differenz einer kleinen Menge a mit
+ * einer indizierten Menge b kosten O(|a| * log(|b|)) statt O(|a| + |b|).
+ *
+ * Zusaetzlich speichert der Index zu jedem Intervall die Anzahl der Elemente
+ * aller vorangehenden Intervalle. Damit lassen sich Rang, k-tes Element und die
+ * Anzahl der Elemente eines Bereichs per binaerer Suche in O(log n) bestimmen,
+ * wobei n die Anzahl der Intervalle ist.
+ *
+ * Fuer Mengen, die sehr haeufig gelesen werden, kann mit setindex_eytzinger
+ * zusaetzlich eine Kopie der Enden in Eytzinger-Reihenfolge (Breitensuche durch
+ * den ausgeglichenen Suchbaum, Kinder von k an 2k und 2k+1) angelegt werden.
+ * Alle Suchen ueber den ganzen Index (setindex_lower_bound und die darauf
+ * aufbauenden Funktionen) laufen dann ohne Verzweigungen ueber dieses Feld: Die
+ * ersten Ebenen teilen sich wenige Cache-Zeilen, und die Zeilen der naechsten
+ * Ebenen werden waehrend des Vergleichs vorab geladen.
+ *
+ * @author alexander loeffler, andre kloodt
+ */
+
+#include "set.h"
+
+/**
+ * Index einer Menge als Feld ihrer Intervalle.
+ */
+typedef struct {
+  /** Anfaenge der Intervalle, aufsteigend sortiert */
+  Element * starts;
+  /** Enden der Intervalle, aufsteigend sortiert */
+  Element * ends;
+  /** Anzahl der Elemente vor dem jeweiligen Intervall, below[count] ist die
+   *  Kardinalitaet der Menge */
+  unsigned long * below;
+  /** Anzahl der Intervalle */
+  unsigned long count;
+  /** Enden in Eytzinger-Reihenfolge ab Position 1, NULL ohne setindex_eytzinger */
+  Element * tree;
+  /** Anfang des Intervalls von tree[k] */
+  Element * treeStarts;
+  /** Position des Intervalls von tree[k] in ends */
+  unsigned long * treePos;
+} SetIndex;
+
+/**
+ * Leseposition in einem Index, Zustand einer Index-Quelle.
+ */
+typedef struct {
+  /** der gelesene Index */
+  const SetIndex * idx;
+  /** Position des naechsten zu liefernden Intervalls */
+  unsigned long pos;
+} SetIndexCursor;
+
+/**
+ * Erzeugt einen Index fuer die Menge s.
+ *
+ * Die Menge s bleibt hierbei unveraendert, spaetere Aenderungen an s wirken sich
+ * nicht auf den Index aus.
+ *
+ * @param[in] s die Menge.
+ *
+ * @return der Index der Menge s.
+ */
+SetIndex setindex_create (Set s);
+
+/**
+ * Legt die Enden eines Index zusaetzlich in Eytzinger-Reihenfolge ab, so dass
+ * Suchen ueber den ganzen Index diese Anordnung verwenden. Kostet O(n) Zeit und
+ * 3 * (n + 1) Worte Speicher. Ein erneuter Aufruf hat keine Wirkung.
+ *
+ * @param[in,out] idx der Index.
+ *
+ * @pre idx ist nicht der Nullzeiger.
+ */
+void setindex_eytzinger (SetIndex * idx);
+
+/**
+ * Gibt den Speicher eines Index frei. Danach beschreibt er die leere Menge.
+ *
+ * @param[in,out] idx der Index.
+ *
+ * @pre idx ist nicht der Nullzeiger.
+ */
+void setindex_delete (SetIndex * idx);
+
+/**
+ * Sucht ab der Position from das erste Intervall, das nicht vor dem Element e endet.
+ *
+ * Die Suche prueft zunaechst einige direkt folgende Intervalle und galoppiert
+ * dann mit exponentiell wachsender Schrittweite, bevor das gefundene Teilstueck
+ * binaer durchsucht wird. Liegt das Ziel nahe bei from, kostet die Suche also
+ * konstante Zeit, ansonsten logarithmisch in der Entfernung.
+ *
+ * @param[in] idx  der Index.
+ * @param[in] from die Position, ab der gesucht wird.
+ * @param[in] e    das gesuchte Element.
+ *
+ * @return Position des ersten Intervalls ab from mit Ende >= e bzw. idx->count,
+ *         falls es kein solches Intervall gibt.
+ *
+ * @pre idx ist nicht der Nullzeiger.
+ * @pre from <= idx->count
+ */
+unsigned long setindex_gallop (const SetIndex * idx, unsigned long from, Element e);
+
+/**
+ * Sucht im ganzen Index das erste Intervall, das nicht vor dem Element e endet,
+ * binaer bzw. ueber die Eytzinger-Anordnung (siehe setindex_eytzinger).
+ *
+ * @param[in] idx der Index.
+ * @param[in] e   das gesuchte Element.
+ *
+ * @return Position des ersten Intervalls mit Ende >= e bzw. idx->count,
+ *         falls es kein solches Intervall gibt.
+ *
+ * @pre idx ist nicht der Nullzeiger.
+ */
+unsigned long setindex_lower_bound (const SetIndex * idx, Element e);
+
+/**
+ * Prueft, ob ein Element in der indizierten Menge enthalten ist.
+ *
+ * @param[in] idx der Index.
+ * @param[in] e   das zu pruefende Element.
+ *
+ * @return 1, falls Element enthalten ist, sonst 0.
+ *
+ * @pre idx ist nicht der Nullzeiger.
+ */
+int setindex_contains (const SetIndex * idx, Element e);
+
+/**
+ * Liefert die Anzahl der Elemente der indizierten Menge in O(1).
+ *
+ * @param[in] idx der Index.
+ *
+ * @return die Kardinalitaet.
+ *
+ * @pre idx ist nicht der Nullzeiger.
+ */
+unsigned long setindex_cardinality (const SetIndex * idx);
+
+/**
+ * Liefert den Rang eines Elements, d.h. die Anzahl der Elemente der indizierten
+ * Menge, die kleiner als e sind. Das Element e muss nicht enthalten sein.
+ *
+ * @param[in] idx der Index.
+ * @param[in] e   das Element.
+ *
+ * @return Anzahl der Elemente kleiner e.
+ *
+ * @pre idx ist nicht der Nullzeiger.
+ */
+unsigned long setindex_rank (const SetIndex * idx, Element e);
+
+/**
+ * Sucht das k-kleinste Element der indizierten Menge (gezaehlt ab 0), also das
+ * Element mit Rang k.
+ *
+ * @param[in]  idx der Index.
+ * @param[in]  k   der Rang.
+ * @param[out] e   das gefundene Element.
+ *
+ * @return 1, falls es ein solches Element gibt, 0 falls k >= Kardinalitaet.
+ *
+ * @pre idx und e sind nicht der Nullzeiger.
+ */
+int setindex_select (const SetIndex * idx, unsigned long k, Element * e);
+
+/**
+ * Liefert die Anzahl der Elemente der indizierten Menge im Bereich [a, b].
+ *
+ * @param[in] idx der Index.
+ * @param[in] a   Anfang des Bereichs.
+ * @param[in] b   Ende des Bereichs.
+ *
+ * @return Anzahl der enthaltenen Elemente e mit a <= e <= b (0, falls a > b).
+ *
+ * @pre idx ist nicht der Nullzeiger.
+ */
+unsigned long setindex_count_range (const SetIndex * idx, Element a, Element b);
+
+/**
+ * Erzeugt eine Quelle, die die Intervalle eines Index liefert. Die Quelle
+ * springt galoppierend (siehe setindex_gallop), so dass set_merge beim
+ * Ueberspringen nur logarithmische Kosten hat.
+ *
+ * @param[out] cursor Leseposition, wird von der Quelle verwendet.
+ * @param[in]  idx    der Index.
+ *
+ * @return die Quelle.
+ *
+ * @pre cursor und idx sind nicht der Nullzeiger.
+ */
+SetSource setindex_source (SetIndexCursor * cursor, const SetIndex * idx);
+
+/**
+ * Erzeugt die Schnittmenge der Menge a mit der indizierten Menge b.
+ *
+ * Fuer jedes Intervall von a wird der passende Bereich von b galoppierend
+ * gesucht, so dass die Kosten bei einer kleinen Menge a und einer grossen
+ * Menge b nur logarithmisch von der Groesse von b abhaengen.
+ *
+ * Die Menge a und der Index b bleiben hierbei unveraendert.
+ *
+ * @param[in] a die erste Menge.
+ * @param[in] b der Index der zweiten Menge.
+ *
+ * @return die Schnittmenge der Mengen a und b.
+ *
+ * @pre b ist nicht der Nullzeiger.
+ */
+Set setindex_intersection (Set a, const SetIndex * b);
+
+/**
+ * Erzeugt die Differenzmenge der Menge a und der indizierten Menge b (a \ b).
+ *
+ * Fuer jedes Intervall von a wird der passende Bereich von b galoppierend
+ * gesucht, so dass die Kosten bei einer kleinen Menge a und einer grossen
+ * Menge b nur logarithmisch von der Groesse von b abhaengen.
+ *
+ * Die Menge a und der Index b bleiben hierbei unveraendert.
+ *
+ * @param[in] a die erste Menge.
+ * @param[in] b der Index der zweiten Menge.
+ *
+ * @return die Differenzmenge der Mengen a und b.
+ *
+ * @pre b ist nicht der Nullzeiger.
+ */
+Set setindex_difference (Set a, const SetIndex * b);
+
+#endif
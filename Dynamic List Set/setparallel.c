@@ -0,0 +1,389 @@
+/**
+ * @file setparallel.c Implementierung paralleler Verknuepfungen grosser Intervall-Listen.
+ *
+ * @author alexander loeffler, andre kloodt
+ */
+
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include <pthread.h>
+
+#include "setparallel.h"
+#include "error.h"
+
+/** kleinstes Element eines Knotens */
+#define NODE_FIRST(NODE) ((NODE)->starts[0])
+
+/** groesstes Element eines Knotens */
+#define NODE_LAST(NODE) ((NODE)->ends[(NODE)->count - 1])
+
+/**
+ * Ein Bereich des Wertebereichs, der von einem Thread verknuepft wird.
+ */
+typedef struct {
+    /** erster Knoten von a bzw. b, der nicht vor low endet */
+    Set startA;
+    Set startB;
+    /** der Bereich [low, high] */
+    Element low;
+    Element high;
+    SetOp op;
+    /** die aufgebaute Teilliste */
+    Set head;
+    Set tail;
+    /** Zaehler der Allokationen des Threads */
+    SetStats stats;
+} Part;
+
+/**
+ * Zustand einer Quelle, die nur die Intervalle einer Liste innerhalb eines
+ * Bereichs liefert und sie dazu an den Bereichsgrenzen abschneidet.
+ */
+typedef struct {
+    SetListCursor cursor;
+    SetSource list;
+    Element low;
+    Element high;
+    int done;
+} ClipState;
+
+
+/**
+ * Liefert das erste Element des Blocks, in dem e liegt.
+ *
+ * @param[in] e das Element.
+ *
+ * @return erstes Element des Blocks.
+ */
+static Element
+chunkBase (Element e) {
+    return e - (Element) ((unsigned long) e & (SET_CHUNK_BITS - 1));
+}
+
+/**
+ * Beschneidet ein gelesenes Intervall auf den Bereich einer Quelle.
+ *
+ * @param[in,out] clip  der Zustand der Quelle.
+ * @param[in]     have  1, falls die Liste ein Intervall geliefert hat.
+ * @param[in,out] start Anfang des Intervalls.
+ * @param[in,out] end   Ende des Intervalls.
+ *
+ * @return 1, falls das Intervall im Bereich liegt, 0 wenn der Bereich erschoepft ist.
+ */
+static int
+clip (ClipState * clip, int have, Element * start, Element * end) {
+    if (!have || *start > clip->high) {
+        clip->done = 1;
+        return 0;
+    }
+    if (*start < clip->low) {
+        *start = clip->low;
+    }
+    if (*end > clip->high) {
+        *end = clip->high;
+    }
+    return 1;
+}
+
+/**
+ * Liefert das naechste Intervall einer beschnittenen Quelle.
+ *
+ * @param[in,out] state der Zustand (ClipState).
+ * @param[out]    start Anfang des Intervalls.
+ * @param[out]    end   Ende des Intervalls.
+ *
+ * @return 1, falls ein Intervall geliefert wurde, 0 wenn die Quelle erschoepft ist.
+ */
+static int
+clipNext (void * state, Element * start, Element * end) {
+    ClipState * c = state;
+    int have = 0;
+
+    if (c->done) {
+        return 0;
+    }
+    /* Intervalle vor dem Bereich ueberspringen */
+    do {
+        have = c->list.next(c->list.state, start, end);
+    } while(have && *end < c->low);
+
+    return clip(c, have, start, end);
+}
+
+/**
+ * Ueberspringt alle Intervalle einer beschnittenen Quelle, die vor e enden,
+ * und liefert das erste verbleibende Intervall.
+ *
+ * @param[in,out] state der Zustand (ClipState).
+ * @param[in]     e     das Element.
+ * @param[out]    start Anfang des Intervalls.
+ * @param[out]    end   Ende des Intervalls.
+ *
+ * @return 1, falls ein Intervall geliefert wurde, 0 wenn die Quelle erschoepft ist.
+ */
+static int
+clipSeek (void * state, Element e, Element * start, Element * end) {
+    ClipState * c = state;
+
+    if (c->done) {
+        return 0;
+    }
+    if (e < c->low) {
+        e = c->low;
+    }
+    return clip(c, c->list.seek(c->list.state, e, start, end), start, end);
+}
+
+/**
+ * Erzeugt eine Quelle, die die Intervalle einer Liste ab dem Knoten from auf
+ * den Bereich [low, high] beschnitten liefert.
+ *
+ * @param[out] c    der Zustand der Quelle.
+ * @param[in]  from erster Knoten, der nicht vor low endet.
+ * @param[in]  low  Anfang des Bereichs.
+ * @param[in]  high Ende des Bereichs.
+ *
+ * @return die Quelle.
+ */
+static SetSource
+clipSource (ClipState * c, Set from, Element low, Element high) {
+    SetSource src;
+
+    c->list = set_source_list(&c->cursor, from);
+    c->low = low;
+    c->high = high;
+    c->done = 0;
+    src.next = clipNext;
+    src.seek = clipSeek;
+    src.state = c;
+    return src;
+}
+
+/**
+ * Verknuepft die Intervalle eines Bereichs und baut daraus eine Teilliste auf.
+ * Wird als Thread gestartet.
+ *
+ * @param[in,out] arg der Bereich (Part).
+ *
+ * @return NULL.
+ */
+static void *
+combinePart (void * arg) {
+    Part * part = arg;
+    ClipState clipA, clipB;
+    SetSource srcA = clipSource(&clipA, part->startA, part->low, part->high);
+    SetSource srcB = clipSource(&clipB, part->startB, part->low, part->high);
+    SetBuilder builder;
+    SetSink sink = set_sink_builder(&builder);
+
+    set_builder_init(&builder);
+    memset(&part->stats, 0, sizeof(SetStats));
+    builder.stats = &part->stats;
+    set_merge(&srcA, &srcB, part->op, &sink);
+
+    part->head = set_builder_finish(&builder);
+    part->tail = part->head;
+    while(!SET_IS_EMPTY(part->tail) && !SET_IS_EMPTY(part->tail->next)){
+        part->tail = part->tail->next;
+    }
+    return NULL;
+}
+
+/**
+ * Legt die Knoten einer Liste in einem Feld ab.
+ *
+ * @param[in]  s     die Menge.
+ * @param[out] count die Anzahl der Knoten.
+ *
+ * @return das Feld der Knoten (NULL bei der leeren Menge), ist mit free freizugeben.
+ */
+static Set *
+collectNodes (Set s, unsigned long * count) {
+    Set * nodes = NULL;
+    Set * grown = NULL;
+    unsigned long size = 0;
+
+    *count = 0;
+    for(; !SET_IS_EMPTY(s); s = s->next){
+        if (*count == size) {
+            size = size == 0 ? 1024 : 2 * size;
+            grown = realloc(nodes, size * sizeof(Set));
+            if (grown == NULL) {
+                exit(ERR_OUT_OF_MEMORY);
+            }
+            nodes = grown;
+        }
+        nodes[(*count)++] = s;
+    }
+    return nodes;
+}
+
+/**
+ * Sucht binaer den ersten Knoten, der nicht vor e endet.
+ *
+ * @param[in] nodes die Knoten einer Liste.
+ * @param[in] count die Anzahl der Knoten.
+ * @param[in] e     das Element.
+ *
+ * @return der Knoten bzw. EMPTY_SET, falls alle Knoten vor e enden.
+ */
+static Set
+findNode (Set * nodes, unsigned long count, Element e) {
+    unsigned long lo = 0;
+    unsigned long hi = count;
+    unsigned long mid = 0;
+
+    while(lo < hi){
+        mid = lo + (hi - lo) / 2;
+        if (NODE_LAST(nodes[mid]) < e) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo < count ? nodes[lo] : EMPTY_SET;
+}
+
+/**
+ * Haengt die Teilliste eines Bereichs an das bisherige Ergebnis an. Grenzt ihr
+ * erstes Intervall direkt an das letzte Intervall des Ergebnisses, werden
+ * beide verschmolzen.
+ *
+ * @param[in,out] tail letzter Knoten des bisherigen Ergebnisses.
+ * @param[in,out] part der Bereich.
+ */
+static void
+stitch (Set tail, Part * part) {
+    Set head = part->head;
+
+    tail->next = head;
+    if (tail->bits != NULL || head->bits != NULL || NODE_LAST(tail) + 1 != NODE_FIRST(head)) {
+        return;
+    }
+
+    NODE_LAST(tail) = head->ends[0];
+    if (head->count > 1) {
+        head->count--;
+        memmove(head->starts, head->starts + 1, head->count * sizeof(Element));
+        memmove(head->ends, head->ends + 1, head->count * sizeof(Element));
+        return;
+    }
+
+    /* der Knoten enthielt nur das verschmolzene Intervall */
+    tail->next = head->next;
+    if (part->tail == head) {
+        part->tail = tail;
+    }
+    head->next = EMPTY_SET;
+    head = set_clear(head);
+}
+
+
+Set
+setparallel_combine (Set a, Set b, SetOp op, unsigned int threads) {
+    Part parts[SETPARALLEL_MAX_THREADS];
+    pthread_t ids[SETPARALLEL_MAX_THREADS];
+    int started[SETPARALLEL_MAX_THREADS];
+    Set * nodesA = NULL;
+    Set * nodesB = NULL;
+    Set * longer = NULL;
+    unsigned long countA = 0, countB = 0, countLonger = 0;
+    unsigned int n = 1, i = 0;
+    Element key = 0;
+    SetStats total;
+    Set result = EMPTY_SET;
+    Set tail = EMPTY_SET;
+
+    if (threads > SETPARALLEL_MAX_THREADS) {
+        threads = SETPARALLEL_MAX_THREADS;
+    }
+    if (threads <= 1) {
+        return set_combine(a, b, op);
+    }
+
+    nodesA = collectNodes(a, &countA);
+    nodesB = collectNodes(b, &countB);
+    if (countA + countB < (unsigned long) threads * SETPARALLEL_MIN_NODES) {
+        free(nodesA);
+        free(nodesB);
+        return set_combine(a, b, op);
+    }
+
+    /* Bereichsgrenzen gleichmaessig ueber die Knoten der laengeren Liste
+     * verteilen und auf Blockgrenzen legen, damit kein Block geteilt wird */
+    longer = countA >= countB ? nodesA : nodesB;
+    countLonger = countA >= countB ? countA : countB;
+    parts[0].low = LONG_MIN;
+    for(i = 1; i < threads; i++){
+        key = chunkBase(NODE_FIRST(longer[countLonger / threads * i]));
+        if (key > parts[n - 1].low) {
+            parts[n - 1].high = key - 1;
+            parts[n].low = key;
+            n++;
+        }
+    }
+    parts[n - 1].high = LONG_MAX;
+
+    for(i = 0; i < n; i++){
+        parts[i].startA = findNode(nodesA, countA, parts[i].low);
+        parts[i].startB = findNode(nodesB, countB, parts[i].low);
+        parts[i].op = op;
+    }
+    free(nodesA);
+    free(nodesB);
+
+    /* Bereiche parallel verknuepfen, den ersten im aufrufenden Thread */
+    for(i = 1; i < n; i++){
+        started[i] = pthread_create(&ids[i], NULL, combinePart, &parts[i]) == 0;
+        if (!started[i]) {
+            combinePart(&parts[i]);
+        }
+    }
+    combinePart(&parts[0]);
+    for(i = 1; i < n; i++){
+        if (started[i]) {
+            pthread_join(ids[i], NULL);
+        }
+    }
+
+    /* Zaehler aller Threads uebernehmen */
+    memset(&total, 0, sizeof(SetStats));
+    for(i = 0; i < n; i++){
+        total.liveNodes += parts[i].stats.liveNodes;
+        total.liveBitmaps += parts[i].stats.liveBitmaps;
+        total.bytesInUse += parts[i].stats.bytesInUse;
+        total.allocations += parts[i].stats.allocations;
+        total.releases += parts[i].stats.releases;
+    }
+    set_stats_add(&total, SET_STATS_ALGEBRA);
+
+    /* Teillisten zusammenfuegen */
+    for(i = 0; i < n; i++){
+        if (SET_IS_EMPTY(parts[i].head)) {
+            continue;
+        }
+        if (SET_IS_EMPTY(tail)) {
+            result = parts[i].head;
+        } else {
+            stitch(tail, &parts[i]);
+        }
+        tail = parts[i].tail;
+    }
+
+    return result;
+}
+
+
+Set
+setparallel_union (Set a, Set b, unsigned int threads) {
+    return setparallel_combine(a, b, SET_OP_UNION, threads);
+}
+
+
+Set
+setparallel_intersection (Set a, Set b, unsigned int threads) {
+    return setparallel_combine(a, b, SET_OP_INTERSECTION, threads);
+}
@@ -0,0 +1,76 @@
+#ifndef __SETPARALLEL_H__
+#define __SETPARALLEL_H__
+
+/**
+ * @file setparallel.h Schnittstelle fuer parallele Verknuepfungen grosser Intervall-Listen.
+ *
+ * Der Wertebereich wird an Intervallgrenzen (genauer: an Blockgrenzen, siehe
+ * SET_CHUNK_BITS) in so viele Bereiche zerlegt, wie Threads verwendet werden.
+ * Jeder Thread verknuepft die Intervalle seines Bereichs mit set_merge und baut
+ * daraus eine eigene Teilliste auf. Die Teillisten werden anschliessend
+ * aneinander gehaengt, wobei an den Bereichsgrenzen aneinander angrenzende
+ * Intervalle verschmolzen werden.
+ *
+ * Nur das Zerlegen (ein Durchlauf beider Listen) und das Zusammenfuegen laufen
+ * sequentiell, die eigentliche Verknuepfung verteilt sich gleichmaessig auf die
+ * Threads.
+ *
+ * @author alexander loeffler, andre kloodt
+ */
+
+#include "set.h"
+
+/** Mindestanzahl an Knoten je Thread, unterhalb derer sequentiell verknuepft wird */
+#ifndef SETPARALLEL_MIN_NODES
+#define SETPARALLEL_MIN_NODES 4096
+#endif
+
+/** Hoechstzahl der Threads einer Verknuepfung */
+#ifndef SETPARALLEL_MAX_THREADS
+#define SETPARALLEL_MAX_THREADS 64
+#endif
+
+/**
+ * Erzeugt die Verknuepfung der beiden Mengen a und b gemaess op als neue Menge
+ * und verwendet dazu bis zu threads Threads.
+ *
+ * Sind die Listen zu kurz, als dass sich die Aufteilung lohnt (weniger als
+ * SETPARALLEL_MIN_NODES Knoten je Thread), oder ist threads hoechstens 1, wird
+ * wie bei set_combine sequentiell verknuepft. Kann ein Thread nicht gestartet
+ * werden, wird sein Bereich im aufrufenden Thread verknuepft.
+ *
+ * Die beiden Mengen a und b bleiben hierbei unveraendert und duerfen waehrend
+ * der Verknuepfung von keinem anderen Thread veraendert werden.
+ *
+ * @param[in] a       die erste Menge.
+ * @param[in] b       die zweite Menge.
+ * @param[in] op      die Verknuepfung.
+ * @param[in] threads die Anzahl der zu verwendenden Threads.
+ *
+ * @return die verknuepfte Menge.
+ */
+Set setparallel_combine (Set a, Set b, SetOp op, unsigned int threads);
+
+/**
+ * Erzeugt die Vereinigungsmenge der Mengen a und b mit bis zu threads Threads.
+ *
+ * @param[in] a       die erste Menge.
+ * @param[in] b       die zweite Menge.
+ * @param[in] threads die Anzahl der zu verwendenden Threads.
+ *
+ * @return die Vereinigungsmenge der Mengen a und b.
+ */
+Set setparallel_union (Set a, Set b, unsigned int threads);
+
+/**
+ * Erzeugt die Schnittmenge der Mengen a und b mit bis zu threads Threads.
+ *
+ * @param[in] a       die erste Menge.
+ * @param[in] b       die zweite Menge.
+ * @param[in] threads die Anzahl der zu verwendenden Threads.
+ *
+ * @return die Schnittmenge der Mengen a und b.
+ */
+Set setparallel_intersection (Set a, Set b, unsigned int threads);
+
+#endif
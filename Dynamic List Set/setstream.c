@@ -0,0 +1,487 @@
+/**
+ * @file setstream.c Implementierung der Verknuepfung sortierter Intervall-Dateien.
+ *
+ * @author alexander loeffler, andre kloodt
+ */
+
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <limits.h>
+
+#include "setstream.h"
+#include "error.h"
+
+/** Hoechstlaenge einer Zeile "start end" im Textformat */
+#define TEXT_LINE_BYTES (2 * (sizeof(Element) * CHAR_BIT / 3 + 2) + 2)
+
+/**
+ * Zustand einer Verknuepfung zweier Dateien, wird wegen der Puffer auf dem
+ * Heap angelegt.
+ */
+typedef struct {
+    SetFileCursor a;
+    SetFileCursor b;
+    SetFileWriter out;
+} StreamState;
+
+
+/**
+ * Liest das naechste Byte einer Datei-Quelle und fuellt den Puffer bei Bedarf nach.
+ *
+ * @param[in,out] c die Leseposition.
+ *
+ * @return das Byte oder EOF am Dateiende bzw. bei einem Lesefehler.
+ */
+static int
+readByte (SetFileCursor * c) {
+    if (c->pos == c->fill) {
+        c->fill = fread(c->buffer, 1, SETSTREAM_BUFFER_BYTES, c->file);
+        c->pos = 0;
+        if (c->fill == 0) {
+            if (ferror(c->file)) {
+                c->status = SETSTREAM_IO_ERROR;
+            }
+            return EOF;
+        }
+    }
+    return c->buffer[c->pos++];
+}
+
+/**
+ * Gibt das zuletzt gelesene Byte (nicht EOF) in den Puffer zurueck.
+ *
+ * @param[in,out] c die Leseposition.
+ */
+static void
+unreadByte (SetFileCursor * c) {
+    assert(c->pos > 0);
+
+    c->pos--;
+}
+
+/**
+ * Ueberliest Leerzeichen, Tabulatoren und Wagenruecklaeufe.
+ *
+ * @param[in,out] c die Leseposition.
+ *
+ * @return das erste folgende Byte (wurde nicht zurueckgegeben) oder EOF.
+ */
+static int
+skipBlanks (SetFileCursor * c) {
+    int ch = 0;
+
+    do {
+        ch = readByte(c);
+    } while(ch == ' ' || ch == '\t' || ch == '\r');
+    return ch;
+}
+
+/**
+ * Liest eine Ganzzahl im Textformat.
+ *
+ * @param[in,out] c die Leseposition.
+ * @param[out]    e die Zahl.
+ *
+ * @return 1, falls eine Zahl gelesen wurde, 0 bei einem Syntaxfehler oder Ueberlauf.
+ */
+static int
+readNumber (SetFileCursor * c, Element * e) {
+    unsigned long value = 0;
+    unsigned long limit = LONG_MAX;
+    unsigned long digit = 0;
+    int negative = 0;
+    int digits = 0;
+    int ch = readByte(c);
+
+    if (ch == '-' || ch == '+') {
+        negative = ch == '-';
+        ch = readByte(c);
+    }
+    if (negative) {
+        limit = (unsigned long) LONG_MAX + 1;
+    }
+
+    while(ch >= '0' && ch <= '9'){
+        digit = (unsigned long) (ch - '0');
+        if (value > (limit - digit) / 10) {
+            return 0;
+        }
+        value = 10 * value + digit;
+        digits++;
+        ch = readByte(c);
+    }
+    if (ch != EOF) {
+        unreadByte(c);
+    }
+
+    if (negative) {
+        *e = value == 0 ? 0 : -(Element) (value - 1) - 1;
+    } else {
+        *e = (Element) value;
+    }
+    return digits > 0;
+}
+
+/**
+ * Liest die naechste Zeile "start end" im Textformat, Leerzeilen werden
+ * uebersprungen. Der Zeilenumbruch am Ende bleibt ungelesen, so dass c->line
+ * danach die Zeile des gelesenen bzw. fehlerhaften Eintrags angibt.
+ *
+ * @param[in,out] c     die Leseposition.
+ * @param[out]    start Anfang des Intervalls.
+ * @param[out]    end   Ende des Intervalls.
+ *
+ * @return 1, falls ein Intervall gelesen wurde, 0 am Dateiende oder bei einem Fehler.
+ */
+static int
+readText (SetFileCursor * c, Element * start, Element * end) {
+    int ch = 0;
+
+    /* Leerzeilen ueberlesen */
+    for(ch = skipBlanks(c); ch == '\n'; ch = skipBlanks(c)){
+        c->line++;
+    }
+    if (ch == EOF) {
+        return 0;
+    }
+    unreadByte(c);
+
+    if (!readNumber(c, start)) {
+        c->status = SETSTREAM_INVALID_INPUT;
+        return 0;
+    }
+    ch = readByte(c);
+    if (ch != ' ' && ch != '\t') {
+        c->status = SETSTREAM_INVALID_INPUT;
+        return 0;
+    }
+    ch = skipBlanks(c);
+    if (ch != EOF) {
+        unreadByte(c);
+    }
+    if (!readNumber(c, end)) {
+        c->status = SETSTREAM_INVALID_INPUT;
+        return 0;
+    }
+
+    /* Zeilenende, der Umbruch wird beim naechsten Eintrag gezaehlt */
+    ch = skipBlanks(c);
+    if (ch == '\n') {
+        unreadByte(c);
+    } else if (ch != EOF) {
+        c->status = SETSTREAM_INVALID_INPUT;
+        return 0;
+    }
+    return 1;
+}
+
+/**
+ * Dekodiert ein Element des Binaerformats.
+ *
+ * @param[in]  bytes die SETSTREAM_ELEMENT_BYTES Bytes, niederwertiges zuerst.
+ * @param[out] e     das Element.
+ *
+ * @return 1, falls der Wert als Element darstellbar ist, sonst 0.
+ */
+static int
+decodeElement (const unsigned char * bytes, Element * e) {
+    unsigned long value = 0;
+    unsigned char fill = (bytes[SETSTREAM_ELEMENT_BYTES - 1] & 0x80) ? 0xFF : 0x00;
+    int i = 0;
+
+    for(i = SETSTREAM_ELEMENT_BYTES - 1; i >= 0; i--){
+        if ((size_t) i >= sizeof(Element)) {
+            /* Bytes jenseits eines Elements duerfen nur das Vorzeichen tragen */
+            if (bytes[i] != fill) {
+                return 0;
+            }
+        } else {
+            value = (value << 8) | bytes[i];
+        }
+    }
+    if ((size_t) SETSTREAM_ELEMENT_BYTES > sizeof(Element)
+            && (bytes[sizeof(Element) - 1] & 0x80) != (fill & 0x80)) {
+        return 0;
+    }
+
+    if (fill) {
+        *e = -(Element) (~value) - 1;
+    } else {
+        *e = (Element) value;
+    }
+    return 1;
+}
+
+/**
+ * Kodiert ein Element im Binaerformat.
+ *
+ * @param[in]  e     das Element.
+ * @param[out] bytes die SETSTREAM_ELEMENT_BYTES Bytes, niederwertiges zuerst.
+ */
+static void
+encodeElement (Element e, unsigned char * bytes) {
+    unsigned long value = (unsigned long) e;
+    size_t i = 0;
+
+    for(i = 0; i < SETSTREAM_ELEMENT_BYTES; i++){
+        if (i < sizeof(Element)) {
+            bytes[i] = (unsigned char) (value & 0xFF);
+            value >>= 8;
+        } else {
+            bytes[i] = e < 0 ? 0xFF : 0x00;
+        }
+    }
+}
+
+/**
+ * Liest das naechste Intervall im Binaerformat.
+ *
+ * @param[in,out] c     die Leseposition.
+ * @param[out]    start Anfang des Intervalls.
+ * @param[out]    end   Ende des Intervalls.
+ *
+ * @return 1, falls ein Intervall gelesen wurde, 0 am Dateiende oder bei einem Fehler.
+ */
+static int
+readBinary (SetFileCursor * c, Element * start, Element * end) {
+    unsigned char bytes[2 * SETSTREAM_ELEMENT_BYTES];
+    int ch = 0;
+    size_t i = 0;
+
+    for(i = 0; i < sizeof(bytes); i++){
+        ch = readByte(c);
+        if (ch == EOF) {
+            /* ein unvollstaendiges Intervall am Dateiende ist ein Fehler */
+            if (i > 0 && c->status == SETSTREAM_OK) {
+                c->status = SETSTREAM_INVALID_INPUT;
+            }
+            return 0;
+        }
+        bytes[i] = (unsigned char) ch;
+    }
+
+    if (!decodeElement(bytes, start) || !decodeElement(bytes + SETSTREAM_ELEMENT_BYTES, end)) {
+        c->status = SETSTREAM_INVALID_INPUT;
+        return 0;
+    }
+    return 1;
+}
+
+/**
+ * Liest das naechste Intervall einer Datei-Quelle im Format der Datei.
+ *
+ * @param[in,out] c     die Leseposition.
+ * @param[out]    start Anfang des Intervalls.
+ * @param[out]    end   Ende des Intervalls.
+ *
+ * @return 1, falls ein Intervall gelesen wurde, 0 am Dateiende oder bei einem Fehler.
+ */
+static int
+readIntervall (SetFileCursor * c, Element * start, Element * end) {
+    int have = c->format == SETSTREAM_BINARY ? readBinary(c, start, end) : readText(c, start, end);
+
+    if (have && *start > *end) {
+        c->status = SETSTREAM_INVALID_INPUT;
+        have = 0;
+    }
+    return have;
+}
+
+/**
+ * Liefert das naechste Intervall einer Datei-Quelle. Ueberlappende und
+ * aneinander grenzende Intervalle der Datei werden dabei zusammengefasst.
+ *
+ * @param[in,out] state die Leseposition (SetFileCursor).
+ * @param[out]    start Anfang des Intervalls.
+ * @param[out]    end   Ende des Intervalls.
+ *
+ * Ist der auf das gelieferte Intervall folgende Eintrag fehlerhaft, wird das
+ * bereits gelesene Intervall noch geliefert, c->status gibt den Fehler an und
+ * der naechste Aufruf liefert 0.
+ *
+ * @return 1, falls ein Intervall geliefert wurde, 0 wenn die Datei erschoepft
+ *         ist oder nach einem Fehler.
+ */
+static int
+fileSourceNext (void * state, Element * start, Element * end) {
+    SetFileCursor * c = state;
+    Element s = 0, e = 0;
+
+    if (!c->pending) {
+        return 0;
+    }
+    *start = c->start;
+    *end = c->end;
+    c->pending = 0;
+
+    while(readIntervall(c, &s, &e)){
+        if (s < *start) {
+            c->status = SETSTREAM_INVALID_INPUT;
+            break;
+        }
+        if (*end != LONG_MAX && s > *end + 1) {
+            c->pending = 1;
+            c->start = s;
+            c->end = e;
+            break;
+        }
+        if (e > *end) {
+            *end = e;
+        }
+    }
+
+    return 1;
+}
+
+
+SetSource
+setstream_source (SetFileCursor * cursor, FILE * file, SetStreamFormat format) {
+    SetSource src;
+
+    assert(cursor != NULL);
+    assert(file != NULL);
+
+    cursor->file = file;
+    cursor->format = format;
+    cursor->pos = 0;
+    cursor->fill = 0;
+    cursor->status = SETSTREAM_OK;
+    cursor->line = 1;
+    cursor->pending = readIntervall(cursor, &cursor->start, &cursor->end);
+
+    src.next = fileSourceNext;
+    src.seek = NULL;
+    src.state = cursor;
+    return src;
+}
+
+/**
+ * Schreibt den Puffer einer Datei-Senke in die Datei.
+ *
+ * @param[in,out] w die Schreibposition.
+ */
+static void
+flushBuffer (SetFileWriter * w) {
+    if (w->fill > 0 && fwrite(w->buffer, 1, w->fill, w->file) != w->fill) {
+        w->status = SETSTREAM_IO_ERROR;
+    }
+    w->fill = 0;
+}
+
+/**
+ * Haengt Bytes an den Puffer einer Datei-Senke an.
+ *
+ * @param[in,out] w     die Schreibposition.
+ * @param[in]     bytes die Bytes.
+ * @param[in]     count Anzahl der Bytes (hoechstens SETSTREAM_BUFFER_BYTES).
+ */
+static void
+writeBytes (SetFileWriter * w, const unsigned char * bytes, size_t count) {
+    size_t i = 0;
+
+    if (w->fill + count > SETSTREAM_BUFFER_BYTES) {
+        flushBuffer(w);
+    }
+    for(i = 0; i < count; i++){
+        w->buffer[w->fill++] = bytes[i];
+    }
+}
+
+/**
+ * Schreibt ein Intervall im Format der Datei.
+ *
+ * @param[in,out] state die Schreibposition (SetFileWriter).
+ * @param[in]     start Anfang des Intervalls.
+ * @param[in]     end   Ende des Intervalls.
+ */
+static void
+fileSinkEmit (void * state, Element start, Element end) {
+    SetFileWriter * w = state;
+    char text[TEXT_LINE_BYTES];
+    unsigned char bytes[2 * SETSTREAM_ELEMENT_BYTES];
+
+    if (w->format == SETSTREAM_BINARY) {
+        encodeElement(start, bytes);
+        encodeElement(end, bytes + SETSTREAM_ELEMENT_BYTES);
+        writeBytes(w, bytes, sizeof(bytes));
+    } else {
+        writeBytes(w, (unsigned char *) text, (size_t) sprintf(text, "%ld %ld\n", start, end));
+    }
+}
+
+
+SetSink
+setstream_sink (SetFileWriter * writer, FILE * file, SetStreamFormat format) {
+    SetSink sink;
+
+    assert(writer != NULL);
+    assert(file != NULL);
+
+    writer->file = file;
+    writer->format = format;
+    writer->fill = 0;
+    writer->status = SETSTREAM_OK;
+
+    sink.emit = fileSinkEmit;
+    sink.state = writer;
+    return sink;
+}
+
+
+SetStreamStatus
+setstream_flush (SetFileWriter * writer) {
+    assert(writer != NULL);
+
+    flushBuffer(writer);
+    if (fflush(writer->file) != 0) {
+        writer->status = SETSTREAM_IO_ERROR;
+    }
+    return writer->status;
+}
+
+
+SetStreamStatus
+setstream_combine (FILE * a, FILE * b, FILE * out, SetOp op, SetStreamFormat format,
+                   SetStreamLocation * where) {
+    StreamState * state = NULL;
+    SetSource srcA, srcB;
+    SetSink sink;
+    SetStreamStatus status = SETSTREAM_OK;
+
+    assert(a != NULL);
+    assert(b != NULL);
+    assert(out != NULL);
+
+    state = malloc(sizeof(StreamState));
+    if (state == NULL) {
+        exit(ERR_OUT_OF_MEMORY);
+    }
+
+    srcA = setstream_source(&state->a, a, format);
+    srcB = setstream_source(&state->b, b, format);
+    sink = setstream_sink(&state->out, out, format);
+    set_merge(&srcA, &srcB, op, &sink);
+    status = setstream_flush(&state->out);
+
+    if (where != NULL) {
+        where->input = 0;
+        where->line = 0;
+    }
+    if (state->a.status != SETSTREAM_OK) {
+        status = state->a.status;
+        if (where != NULL) {
+            where->input = 1;
+            where->line = format == SETSTREAM_TEXT ? state->a.line : 0;
+        }
+    } else if (state->b.status != SETSTREAM_OK) {
+        status = state->b.status;
+        if (where != NULL) {
+            where->input = 2;
+            where->line = format == SETSTREAM_TEXT ? state->b.line : 0;
+        }
+    }
+
+    free(state);
+    return status;
+}
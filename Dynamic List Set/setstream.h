@@ -0,0 +1,174 @@
+#ifndef __SETSTREAM_H__
+#define __SETSTREAM_H__
+
+/**
+ * @file setstream.h Schnittstelle fuer Verknuepfungen von Mengen, die als
+ * sortierte Intervall-Dateien vorliegen.
+ *
+ * Die Intervalle werden gepuffert aus den Dateien gelesen, mit set_merge
+ * verknuepft und gepuffert in die Ausgabe geschrieben, ohne dass eine der
+ * Mengen als Liste aufgebaut wird. Der Speicherbedarf ist damit unabhaengig von
+ * der Groesse der Mengen.
+ *
+ * Formate einer Intervall-Datei:
+ * - Text: je Zeile ein Intervall "start end" (zwei Ganzzahlen, durch Leerzeichen
+ *   oder Tabulatoren getrennt), Leerzeilen werden ignoriert.
+ * - Binaer: je Intervall zwei vorzeichenbehaftete 64-Bit-Ganzzahlen (start,
+ *   end) im Zweierkomplement, niederwertiges Byte zuerst.
+ *
+ * Die Intervalle einer Eingabe muessen nach ihrem Anfang aufsteigend sortiert
+ * sein, sich ueberlappende oder aneinander grenzende Intervalle werden beim
+ * Lesen zusammengefasst. Die Ausgabe enthaelt die Intervalle in der kanonischen
+ * Form (sortiert, disjunkt, nicht aneinander grenzend).
+ *
+ * @author alexander loeffler, andre kloodt
+ */
+
+#include <stdio.h>
+
+#include "set.h"
+
+/** Groesse der Lese- und Schreibpuffer in Bytes */
+#ifndef SETSTREAM_BUFFER_BYTES
+#define SETSTREAM_BUFFER_BYTES 65536
+#endif
+
+/** Anzahl der Bytes eines Elements im Binaerformat */
+#define SETSTREAM_ELEMENT_BYTES 8
+
+/**
+ * Format einer Intervall-Datei.
+ */
+typedef enum {
+  /** je Zeile "start end" */
+  SETSTREAM_TEXT,
+  /** je Intervall zwei 64-Bit-Ganzzahlen */
+  SETSTREAM_BINARY
+} SetStreamFormat;
+
+/**
+ * Ergebnis einer Verknuepfung von Dateien.
+ */
+typedef enum {
+  /** kein Fehler */
+  SETSTREAM_OK = 0,
+  /** eine Eingabe ist syntaktisch falsch oder nicht sortiert */
+  SETSTREAM_INVALID_INPUT,
+  /** Fehler beim Lesen oder Schreiben einer Datei */
+  SETSTREAM_IO_ERROR
+} SetStreamStatus;
+
+/**
+ * Ort eines Fehlers in den Eingaben einer Verknuepfung von Dateien.
+ */
+typedef struct {
+  /** fehlerhafte Eingabe: 1 fuer die erste, 2 fuer die zweite, 0 ohne Fehler */
+  int input;
+  /** Zeile des fehlerhaften Eintrags (nur im Textformat, sonst 0) */
+  unsigned long line;
+} SetStreamLocation;
+
+/**
+ * Leseposition in einer Intervall-Datei, Zustand einer Datei-Quelle.
+ */
+typedef struct {
+  /** die Datei */
+  FILE * file;
+  /** das Format der Datei */
+  SetStreamFormat format;
+  /** Lesepuffer */
+  unsigned char buffer[SETSTREAM_BUFFER_BYTES];
+  /** naechstes zu lesendes Byte im Puffer */
+  size_t pos;
+  /** Anzahl der gueltigen Bytes im Puffer */
+  size_t fill;
+  /** 1, falls bereits ein gelesenes Intervall zwischengespeichert ist */
+  int pending;
+  /** das zwischengespeicherte Intervall */
+  Element start;
+  Element end;
+  /** Fehler beim Lesen (SETSTREAM_OK, falls keiner aufgetreten ist) */
+  SetStreamStatus status;
+  /** Zeile des zuletzt gelesenen bzw. des fehlerhaften Eintrags (nur im Textformat) */
+  unsigned long line;
+} SetFileCursor;
+
+/**
+ * Schreibposition in einer Intervall-Datei, Zustand einer Datei-Senke.
+ */
+typedef struct {
+  /** die Datei */
+  FILE * file;
+  /** das Format der Datei */
+  SetStreamFormat format;
+  /** Schreibpuffer */
+  unsigned char buffer[SETSTREAM_BUFFER_BYTES];
+  /** Anzahl der Bytes im Puffer */
+  size_t fill;
+  /** Fehler beim Schreiben (SETSTREAM_OK, falls keiner aufgetreten ist) */
+  SetStreamStatus status;
+} SetFileWriter;
+
+/**
+ * Erzeugt eine Quelle, die die Intervalle einer sortierten Intervall-Datei
+ * liefert. Ist die Datei fehlerhaft, endet die Quelle beim Fehler und
+ * cursor->status gibt den Fehler an.
+ *
+ * @param[out] cursor Leseposition, wird von der Quelle verwendet.
+ * @param[in]  file   die zum Lesen geoeffnete Datei.
+ * @param[in]  format das Format der Datei.
+ *
+ * @return die Quelle.
+ *
+ * @pre cursor und file sind nicht der Nullzeiger.
+ */
+SetSource setstream_source (SetFileCursor * cursor, FILE * file, SetStreamFormat format);
+
+/**
+ * Erzeugt eine Senke, die alle Intervalle gepuffert in eine Datei schreibt.
+ * Nach dem letzten Intervall ist setstream_flush aufzurufen.
+ *
+ * @param[out] writer Schreibposition, wird von der Senke verwendet.
+ * @param[in]  file   die zum Schreiben geoeffnete Datei.
+ * @param[in]  format das Format der Datei.
+ *
+ * @return die Senke.
+ *
+ * @pre writer und file sind nicht der Nullzeiger.
+ */
+SetSink setstream_sink (SetFileWriter * writer, FILE * file, SetStreamFormat format);
+
+/**
+ * Schreibt den Puffer einer Datei-Senke in die Datei.
+ *
+ * @param[in,out] writer die Schreibposition.
+ *
+ * @return SETSTREAM_OK oder SETSTREAM_IO_ERROR, falls ein Schreibfehler aufgetreten ist.
+ *
+ * @pre writer ist nicht der Nullzeiger.
+ */
+SetStreamStatus setstream_flush (SetFileWriter * writer);
+
+/**
+ * Verknuepft die Intervall-Dateien a und b gemaess op und schreibt das Ergebnis
+ * im selben Format nach out.
+ *
+ * Tritt ein Fehler auf, endet die fehlerhafte Eingabe an dieser Stelle, die
+ * bereits geschriebene Ausgabe ist dann unvollstaendig. where gibt dann an,
+ * welche Eingabe fehlerhaft ist und in welcher Zeile der Fehler liegt.
+ *
+ * @param[in]  a      die erste Datei.
+ * @param[in]  b      die zweite Datei.
+ * @param[out] out    die Ausgabedatei.
+ * @param[in]  op     die Verknuepfung.
+ * @param[in]  format das Format aller drei Dateien.
+ * @param[out] where  Ort eines Fehlers in den Eingaben, darf der Nullzeiger sein.
+ *
+ * @return SETSTREAM_OK oder der aufgetretene Fehler.
+ *
+ * @pre a, b und out sind nicht der Nullzeiger.
+ */
+SetStreamStatus setstream_combine (FILE * a, FILE * b, FILE * out, SetOp op, SetStreamFormat format,
+                                   SetStreamLocation * where);
+
+#endif
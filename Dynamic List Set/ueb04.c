@@ -6,12 +6,50 @@
 
 #include <assert.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
 
 #include "error.h"
 #include "set.h"
+#include "setstream.h"
 
 extern int setlist_refs;
 
+/** Hoechstlaenge des Namens einer Menge im Sitzungsmodus */
+#define SESSION_NAME_LENGTH 31
+
+/** Hoechstanzahl der Woerter eines Befehls im Sitzungsmodus */
+#define SESSION_MAX_TOKENS 8
+
+/** Anzahl der Elemente, die mit der Option -p ausgegeben werden */
+#define PREVIEW_ELEMENTS 20
+
+/** Form, in der printSet Mengen ausgibt (Optionen -i und -p) */
+static SetPrintMode printMode = SET_PRINT_EXPANDED;
+
+/**
+ * Eine benannte Menge im Sitzungsmodus.
+ */
+typedef struct {
+  /** der Name */
+  char name[SESSION_NAME_LENGTH + 1];
+  /** die Menge */
+  Set set;
+} Binding;
+
+/**
+ * Alle benannten Mengen einer Sitzung.
+ */
+typedef struct {
+  /** die Mengen */
+  Binding * bindings;
+  /** Anzahl der Mengen */
+  unsigned long count;
+  /** Anzahl der Plaetze in bindings */
+  unsigned long size;
+} Session;
+
 /**
  * Gibt die Hilfe in die uebergebene Datei beziehungsweise den uebergebenen Stream 
  * (stderr / stdout) aus.
@@ -29,13 +67,13 @@ printUsage(FILE * stream) {
   fprintf(stream, "%s\n", "ueb04 -h");
   fprintf(stream, "%s\n", "  Show this help and exit.");
   fprintf(stream, "%s\n", "");
-  fprintf(stream, "%s\n", "ueb04 ELEM_OP SET E [-m]");
+  fprintf(stream, "%s\n", "ueb04 ELEM_OP SET E [-m|-s]");
   fprintf(stream, "%s\n", "  where ELEM_OP is one of:");
   fprintf(stream, "%s\n", "  e - check whether SET contains E or not");
   fprintf(stream, "%s\n", "  r - remove E from SET");
   fprintf(stream, "%s\n", "  I - insert E into SET"); /* NEU */ 
   fprintf(stream, "%s\n", "");
-  fprintf(stream, "%s\n", "ueb04 UN_OP SET [-m]");
+  fprintf(stream, "%s\n", "ueb04 UN_OP SET [-m|-s]");
   fprintf(stream, "%s\n", "  where UN_OP is one of:");
   fprintf(stream, "%s\n", "  o - print SET");
   fprintf(stream, "%s\n", "  R - remove all elements from SET");
@@ -44,7 +82,7 @@ printUsage(FILE * stream) {
   fprintf(stream, "%s\n", "  m - minimum of SET");
   fprintf(stream, "%s\n", "  M - maximum of SET");
   fprintf(stream, "%s\n", "");
-  fprintf(stream, "%s\n", "ueb04 BIN_OP SET1 SET2 [-m]");
+  fprintf(stream, "%s\n", "ueb04 BIN_OP SET1 SET2 [-m|-s]");
   fprintf(stream, "%s\n", "  where BIN_OP is one of:");
   fprintf(stream, "%s\n", "  s - SET1 subset of SET2?");
   fprintf(stream, "%s\n", "  = - SET1 equals SET2?");
@@ -53,10 +91,64 @@ printUsage(FILE * stream) {
   fprintf(stream, "%s\n", "  d - difference between SET1 and SET2 (SET1 \\ SET2)");
   fprintf(stream, "%s\n", "  D - symmetric difference of SET1 and SET2");
   fprintf(stream, "%s\n", "");
-  fprintf(stream, "%s\n", "SET, SET1, SET2 - one set of elements (e.g. {1,2,3})");
+  fprintf(stream, "%s\n", "ueb04 W SET FILE [-m|-s]");
+  fprintf(stream, "%s\n", "  writes SET to FILE in the compact binary set format");
+  fprintf(stream, "%s\n", "");
+  fprintf(stream, "%s\n", "ueb04 f BIN_OP FILE1 FILE2 [-b|-m|-s]");
+  fprintf(stream, "%s\n", "  streams the sorted interval files FILE1 and FILE2 through BIN_OP");
+  fprintf(stream, "%s\n", "  (u, i, d or D) and writes the resulting intervals to stdout");
+  fprintf(stream, "%s\n", "");
+  fprintf(stream, "%s\n", "ueb04 S [-m|-s]");
+  fprintf(stream, "%s\n", "  reads commands from stdin, one per line, and keeps named sets in memory:");
+  fprintf(stream, "%s\n", "  NAME = SET            binds SET to NAME");
+  fprintf(stream, "%s\n", "  NAME = UN_OP SET      binds the result of c or R");
+  fprintf(stream, "%s\n", "  NAME = ELEM_OP SET E  binds the result of r or I");
+  fprintf(stream, "%s\n", "  NAME = BIN_OP SET1 SET2  binds the result of u, i, d or D");
+  fprintf(stream, "%s\n", "  OP ARGS               runs any other operation (including W) and prints its result");
+  fprintf(stream, "%s\n", "  where SET, SET1 and SET2 may also be names; empty lines and lines");
+  fprintf(stream, "%s\n", "  starting with # are ignored");
+  fprintf(stream, "%s\n", "");
+  fprintf(stream, "%s\n", "SET, SET1, SET2 - one set of elements (e.g. {1,2,3} or {1..1000,5000})");
+  fprintf(stream, "%s\n", "  or @FILE to load a set written by W (e.g. @set.bin)");
   fprintf(stream, "%s\n", "E - one element (e.g. 1)");
+  fprintf(stream, "%s\n", "FILE1, FILE2 - intervals sorted by start, one \"start end\" per line");
   fprintf(stream, "%s\n", "All elements must be integers"); /* Angepasst */
   fprintf(stream, "%s\n", "-m - activates memory management (optional)"); /* NEU */
+  fprintf(stream, "%s\n", "-s - prints allocation statistics and the shape of SET (SET1) to stderr (optional)");
+  fprintf(stream, "%s\n", "-b - FILE1, FILE2 and the output use the binary format (two 64 bit integers per interval, optional)");
+  fprintf(stream, "%s\n", "-i - prints resulting sets in interval form (e.g. {1..1000,5000}) without the list on stderr (optional)");
+  fprintf(stream, "%s\n", "-p - prints only the first 20 elements of resulting sets without the list on stderr (optional)");
+  fprintf(stream, "%s\n", "Options except -b may be combined (e.g. -mi)");
+}
+
+/**
+ * Wertet die optionalen Optionen am Ende der Kommandozeile aus. Mehrere
+ * Optionen duerfen in einem Argument stehen (z.B. -mi). Die Optionen -i und -p
+ * setzen die Ausgabeform von printSet.
+ *
+ * @param[in]  string            das Argument.
+ * @param[out] memory_management wird bei -m auf 1 gesetzt.
+ * @param[out] statistics        wird bei -s auf 1 gesetzt.
+ */
+void
+readOption(char * string, int * memory_management, int * statistics) {
+  char 
+      * arg = NULL
+    ;
+
+  if (string[0] == '-') {
+    for (arg = string + 1; *arg != '\0'; arg++) {
+      if (*arg == 'm') {
+        *memory_management = 1;
+      } else if (*arg == 's') {
+        *statistics = 1;
+      } else if (*arg == 'i') {
+        printMode = SET_PRINT_INTERVALS;
+      } else if (*arg == 'p') {
+        printMode = SET_PRINT_PREVIEW;
+      }
+    }
+  }
 }
 
 /**
@@ -64,9 +156,11 @@ printUsage(FILE * stream) {
  * 
  * Eine Menge besteht aus einer oeffnenden ({) und einer schliessenden (}) Klammer,
  * zwischen denen beliebig viele Ganzzahlen stehen. Zwei Ganzzahlen sind dabei jeweils 
- * durch ein Komma (,) getrennt. Vor, nach, und zwischen saemtlichen Zeichen (ausser 
- * zwischen den Ziffern einer Zahl) darf beliebig viel Whitespace gemaess der C-Funktion
- * isspace stehen. Zahlen werden gemaess sscanf mit "%ld" gelesen.
+ * durch ein Komma (,) getrennt. Anstelle einer Ganzzahl darf auch ein Bereich der Form
+ * "a..b" (mit a <= b) stehen, der alle Zahlen von a bis einschliesslich b umfasst.
+ * Vor, nach, und zwischen saemtlichen Zeichen (ausser zwischen den Ziffern einer Zahl
+ * und den beiden Punkten eines Bereichs) darf beliebig viel Whitespace gemaess der
+ * C-Funktion isspace stehen. Zahlen werden gemaess sscanf mit "%ld" gelesen.
  * 
  * Saemtliche auftretenden Fehler beim Einlesen fuehren zu dem Rueckgabewert 
  * ERR_INVALID_SET_SYNTAX.
@@ -74,6 +168,7 @@ printUsage(FILE * stream) {
  * Beispiele:
  * "{1,2,3}"
  * " { 1 , 2 , 3 } "
+ * "{1..1000000, 5000000}"
  * 
  * @param[in]     string zu verarbeitende Zeichenkette
  * @param[in,out] error Zeiger auf den Fehlercode
@@ -95,13 +190,23 @@ readSet (char * string, Errorcode * error) {
     Set
         result = EMPTY_SET
       ;
+    SetBuilder
+        builder
+      ;
+    Element
+        last = 0
+      ;
     char 
         delimiter = '\0'
       , d = '\0'
       ;
     int 
         num = 0
+      , sorted = 1
+      , count = 0
       ;
+
+    set_builder_init(&builder);
   
     /* { ueberlesen */
     if (sscanf(string, " %c%n", &delimiter, &num) == 1 && delimiter == '{') {
@@ -118,17 +223,44 @@ readSet (char * string, Errorcode * error) {
     }
 
     while (! (*error) && delimiter == ',') {
-      Element e = 0;
+      Element e = 0
+            , f = 0
+            ;
     
       /* Element einlesen */
       if (sscanf(string, "%ld%n", &e, &num) != 1) {
         *error = ERR_INVALID_SET_SYNTAX;
       }
       string += num;
+      f = e;
+
+      /* optionales Bereichsende (..) einlesen */
+      if (! (*error)) {
+        num = -1;
+        sscanf(string, " ..%n", &num);
+        if (num >= 0) {
+          string += num;
+          if (sscanf(string, "%ld%n", &f, &num) != 1 || f < e) {
+            *error = ERR_INVALID_SET_SYNTAX;
+          }
+          string += num;
+        }
+      }
    
       if (! (*error)) {
         
-        result = set_insert (result, e);
+        /* Solange die Elemente aufsteigend sortiert sind, wird nur angehaengt */
+        if (sorted && (count == 0 || e >= last)) {
+          set_builder_append_range(&builder, e, f);
+        } else {
+          if (sorted) {
+            result = set_builder_finish(&builder);
+            sorted = 0;
+          }
+          result = set_insert_range (result, e, f);
+        }
+        last = e;
+        count++;
       
         /* Trennzeichen (, oder }) ueberlesen */
         if (sscanf(string, " %c%n", &delimiter, &num) != 1) {
@@ -141,25 +273,662 @@ readSet (char * string, Errorcode * error) {
     if (! (*error) && (delimiter != '}' || sscanf(string, " %c", &d) == 1)) {
       *error = ERR_INVALID_SET_SYNTAX;
     }
+
+    if (sorted) {
+      result = set_builder_finish(&builder);
+    }
   
     return result;
   }
 }
 
+/**
+ * Verknuepft zwei sortierte Intervall-Dateien, ohne sie als Mengen einzulesen,
+ * und schreibt das Ergebnis auf stdout.
+ *
+ * @param[in] op     die Verknuepfung (u, i, d oder D).
+ * @param[in] name1  Name der ersten Datei.
+ * @param[in] name2  Name der zweiten Datei.
+ * @param[in] binary 1, falls die Dateien im Binaerformat vorliegen.
+ *
+ * @return Fehlercode (ERR_NULL, wenn kein Fehler aufgetreten ist).
+ */
+Errorcode
+streamFiles (char op, char * name1, char * name2, int binary) {
+  Errorcode 
+      error = ERR_NULL
+    ;
+  SetOp 
+      setOp = SET_OP_UNION
+    ;
+  SetStreamStatus 
+      status = SETSTREAM_OK
+    ;
+  SetStreamLocation
+      where
+    ;
+  FILE 
+      * file1 = NULL
+    , * file2 = NULL
+    ;
+
+  switch (op) {
+    case 'u':
+      setOp = SET_OP_UNION;
+      break;
+    case 'i':
+      setOp = SET_OP_INTERSECTION;
+      break;
+    case 'd':
+      setOp = SET_OP_DIFFERENCE;
+      break;
+    case 'D':
+      setOp = SET_OP_SYMMETRIC_DIFFERENCE;
+      break;
+    default:
+      error = ERR_INVALID_ARG;
+  }
+
+  if (!error) {
+    file1 = fopen(name1, binary ? "rb" : "r");
+    file2 = fopen(name2, binary ? "rb" : "r");
+    if (file1 == NULL || file2 == NULL) {
+      error = ERR_INVALID_ARG;
+    }
+  }
+
+  if (!error) {
+    status = setstream_combine(file1, file2, stdout, setOp, binary ? SETSTREAM_BINARY : SETSTREAM_TEXT, &where);
+    if (status == SETSTREAM_INVALID_INPUT) {
+      error = ERR_INVALID_SET_SYNTAX;
+      fprintf(stderr, "%s", where.input == 1 ? name1 : name2);
+      if (where.line > 0) {
+        fprintf(stderr, ", line %lu", where.line);
+      }
+      fprintf(stderr, ": ");
+    } else if (status != SETSTREAM_OK) {
+      error = ERR_UNKNOWN;
+    }
+  }
+
+  if (file1 != NULL) {
+    fclose(file1);
+  }
+  if (file2 != NULL) {
+    fclose(file2);
+  }
+
+  return error;
+}
+
+/**
+ * Liest eine Menge aus einem Argument. Beginnt das Argument mit @, wird die
+ * Menge aus der so benannten, mit set_save geschriebenen Datei geladen,
+ * ansonsten wie bei readSet aus dem Argument selbst gelesen.
+ *
+ * @param[in]     string zu verarbeitende Zeichenkette
+ * @param[in,out] error Zeiger auf den Fehlercode
+ *
+ * @pre string != NULL
+ * @pre error != NULL
+ * @pre *error == ERR_NULL
+ *
+ * @return die gelesene Menge
+ */
+Set
+readSetArgument (char * string, Errorcode * error) {
+  Set 
+      s = EMPTY_SET
+    ;
+  FILE 
+      * file = NULL
+    ;
+
+  assert (string != NULL);
+  assert (error != NULL); 
+
+  if (string[0] != '@') {
+    return readSet(string, error);
+  }
+
+  file = fopen(string + 1, "rb");
+  if (file == NULL) {
+    *error = ERR_INVALID_ARG;
+  } else {
+    if (!set_load(file, &s)) {
+      *error = ERR_INVALID_SET_SYNTAX;
+    }
+    fclose(file);
+  }
+  return s;
+}
+
+/**
+ * Schreibt eine Menge im Binaerformat von set_save in eine Datei.
+ *
+ * @param[in] s    die Menge.
+ * @param[in] name Name der Datei.
+ *
+ * @return Fehlercode (ERR_NULL, wenn kein Fehler aufgetreten ist).
+ */
+Errorcode
+writeSetFile (Set s, char * name) {
+  FILE 
+      * file = fopen(name, "wb")
+    ;
+  int 
+      ok = 0
+    ;
+
+  if (file == NULL) {
+    return ERR_INVALID_ARG;
+  }
+  ok = set_save(file, s);
+  if (fclose(file) != 0 || !ok) {
+    return ERR_UNKNOWN;
+  }
+  return ERR_NULL;
+}
+
 /**
  * Gibt das uebergebene Set als Menge auf stdout und als Repraesentation der
- * internen Liste auf stderr.
+ * internen Liste auf stderr. In der Intervall-Form und der Vorschau (Optionen
+ * -i und -p) entfaellt die Liste.
  *
  * @param[in] s das Set
  */
 void 
 printSet(Set s) {
   
-  set_print(stdout, s);
+  set_print_as(stdout, s, printMode, PREVIEW_ELEMENTS);
   fprintf(stdout, "\n");
 
-  set_print_list(stderr, s); 
-  fprintf(stderr, "\n");
+  if (printMode == SET_PRINT_EXPANDED) {
+    set_print_list(stderr, s); 
+    fprintf(stderr, "\n");
+  }
+}
+
+/**
+ * Liest eine Zeile beliebiger Laenge ohne den Zeilenumbruch ein.
+ *
+ * @param[in]     stream Datei bzw. Stream, aus dem gelesen wird.
+ * @param[in,out] buffer Puffer fuer die Zeile, wird bei Bedarf vergroessert.
+ * @param[in,out] size   Groesse des Puffers.
+ *
+ * @return 1, falls eine Zeile gelesen wurde, 0 am Dateiende.
+ */
+int
+readLine(FILE * stream, char ** buffer, size_t * size) {
+  size_t 
+      length = 0
+    ;
+  int 
+      c = 0
+    ;
+
+  while ((c = getc(stream)) != EOF && c != '\n') {
+    if (length + 1 >= *size) {
+      char * grown = realloc(*buffer, *size == 0 ? 256 : 2 * *size);
+      if (grown == NULL) {
+        exit(ERR_OUT_OF_MEMORY);
+      }
+      *buffer = grown;
+      *size = *size == 0 ? 256 : 2 * *size;
+    }
+    (*buffer)[length++] = (char) c;
+  }
+  if (c == EOF && length == 0) {
+    return 0;
+  }
+  if (*size == 0) {
+    *buffer = malloc(1);
+    if (*buffer == NULL) {
+      exit(ERR_OUT_OF_MEMORY);
+    }
+    *size = 1;
+  }
+  (*buffer)[length] = '\0';
+  return 1;
+}
+
+/**
+ * Zerlegt eine Zeile in Woerter. Ein Wort ist entweder eine Menge in
+ * geschweiften Klammern (die Leerzeichen enthalten darf) oder eine Folge von
+ * Zeichen ohne Whitespace. Die Zeile wird dabei veraendert.
+ *
+ * @param[in,out] line   die Zeile.
+ * @param[out]    tokens die Woerter.
+ *
+ * @return Anzahl der Woerter oder -1, falls es mehr als SESSION_MAX_TOKENS sind
+ *         oder eine Menge nicht geschlossen wird.
+ */
+int
+splitLine(char * line, char * tokens[]) {
+  int 
+      count = 0
+    ;
+
+  while (*line != '\0') {
+    if (isspace((unsigned char) *line)) {
+      line++;
+    } else if (count == SESSION_MAX_TOKENS) {
+      return -1;
+    } else {
+      tokens[count++] = line;
+      if (*line == '{') {
+        line = strchr(line, '}');
+        if (line == NULL) {
+          return -1;
+        }
+        line++;
+      } else {
+        while (*line != '\0' && !isspace((unsigned char) *line)) {
+          line++;
+        }
+      }
+      if (*line != '\0') {
+        *line++ = '\0';
+      }
+    }
+  }
+  return count;
+}
+
+/**
+ * Prueft, ob eine Zeichenkette ein gueltiger Name einer Menge ist (Buchstabe
+ * oder _, gefolgt von Buchstaben, Ziffern oder _).
+ *
+ * @param[in] name die Zeichenkette.
+ *
+ * @return 1, falls der Name gueltig ist, sonst 0.
+ */
+int
+isName(char * name) {
+  size_t 
+      i = 0
+    ;
+
+  if (!isalpha((unsigned char) name[0]) && name[0] != '_') {
+    return 0;
+  }
+  for (i = 1; name[i] != '\0'; i++) {
+    if (!isalnum((unsigned char) name[i]) && name[i] != '_') {
+      return 0;
+    }
+  }
+  return i <= SESSION_NAME_LENGTH;
+}
+
+/**
+ * Sucht eine benannte Menge einer Sitzung.
+ *
+ * @param[in] session die Sitzung.
+ * @param[in] name    der Name.
+ *
+ * @return die benannte Menge oder NULL, falls es den Namen nicht gibt.
+ */
+Binding *
+findBinding(Session * session, char * name) {
+  unsigned long 
+      i = 0
+    ;
+
+  for (i = 0; i < session->count; i++) {
+    if (strcmp(session->bindings[i].name, name) == 0) {
+      return &session->bindings[i];
+    }
+  }
+  return NULL;
+}
+
+/**
+ * Bindet eine Menge an einen Namen. Eine zuvor unter dem Namen gebundene
+ * Menge wird freigegeben.
+ *
+ * @param[in,out] session die Sitzung.
+ * @param[in]     name    der Name.
+ * @param[in]     s       die Menge, gehoert danach der Sitzung.
+ */
+void
+bind(Session * session, char * name, Set s) {
+  Binding 
+      * binding = findBinding(session, name)
+    ;
+
+  if (binding == NULL) {
+    if (session->count == session->size) {
+      Binding * grown = realloc(session->bindings, 
+                                (session->size == 0 ? 16 : 2 * session->size) * sizeof(Binding));
+      if (grown == NULL) {
+        exit(ERR_OUT_OF_MEMORY);
+      }
+      session->bindings = grown;
+      session->size = session->size == 0 ? 16 : 2 * session->size;
+    }
+    binding = &session->bindings[session->count++];
+    strcpy(binding->name, name);
+    binding->set = EMPTY_SET;
+  }
+  binding->set = set_clear(binding->set);
+  binding->set = s;
+}
+
+/**
+ * Liefert den Wert eines Operanden, also eine Menge in geschweiften Klammern
+ * oder den Namen einer gebundenen Menge.
+ *
+ * @param[in,out] session die Sitzung.
+ * @param[in]     token   der Operand.
+ * @param[in]     target  Name, an den das Ergebnis gebunden wird, oder NULL. 
+ *                        Ist der Operand dieser Name, wird die Menge aus der 
+ *                        Sitzung entnommen statt kopiert.
+ * @param[in]     owned   1, falls der Aufrufer eine eigene Menge benoetigt,
+ *                        die er veraendern darf.
+ * @param[out]    temporary wird auf 1 gesetzt, falls der Aufrufer die
+ *                        gelieferte Menge freigeben muss.
+ * @param[in,out] error   Zeiger auf den Fehlercode.
+ *
+ * @return die Menge.
+ */
+Set
+readOperand(Session * session, char * token, char * target, int owned, int * temporary, Errorcode * error) {
+  Binding 
+      * binding = NULL
+    ;
+  Set 
+      s = EMPTY_SET
+    ;
+
+  *temporary = 0;
+  if (token[0] == '{' || token[0] == '@') {
+    s = readSetArgument(token, error);
+    *temporary = 1;
+  } else if ((binding = findBinding(session, token)) == NULL) {
+    *error = ERR_INVALID_ARG;
+  } else if (!owned) {
+    s = binding->set;
+  } else if (target != NULL && strcmp(token, target) == 0) {
+    /* die Menge wird ueberschrieben und kann direkt veraendert werden */
+    s = binding->set;
+    binding->set = EMPTY_SET;
+    *temporary = 1;
+  } else {
+    s = set_copy(binding->set);
+    *temporary = 1;
+  }
+  return s;
+}
+
+/**
+ * Fuehrt einen Befehl einer Sitzung aus.
+ *
+ * @param[in,out] session die Sitzung.
+ * @param[in]     tokens  die Woerter des Befehls.
+ * @param[in]     count   Anzahl der Woerter.
+ *
+ * @return Fehlercode (ERR_NULL, wenn kein Fehler aufgetreten ist).
+ */
+Errorcode
+runCommand(Session * session, char * tokens[], int count) {
+  Errorcode 
+      error = ERR_NULL
+    ;
+  char 
+      * target = NULL
+    , op = '\0'
+    , dummy = '\0'
+    ;
+  Set 
+      a = EMPTY_SET
+    , b = EMPTY_SET
+    , result = EMPTY_SET
+    ;
+  int 
+      tempA = 0
+    , tempB = 0
+    , hasResult = 0
+    ;
+  Element 
+      e = 0
+    ;
+
+  /* Zuweisung NAME = ... */
+  if (count >= 3 && strcmp(tokens[1], "=") == 0) {
+    if (!isName(tokens[0])) {
+      return ERR_INVALID_ARG;
+    }
+    target = tokens[0];
+    tokens += 2;
+    count -= 2;
+
+    /* NAME = SET bzw. NAME = NAME */
+    if (count == 1) {
+      a = readOperand(session, tokens[0], NULL, 1, &tempA, &error);
+      if (!error) {
+        bind(session, target, a);
+      } else if (tempA) {
+        a = set_clear(a);
+      }
+      return error;
+    }
+  }
+
+  /* an einen Namen koennen nur Operationen gebunden werden, die eine Menge liefern */
+  if (sscanf(tokens[0], "%c%c", &op, &dummy) != 1 
+      || (target != NULL && strchr("rIRcuidD", op) == NULL)) {
+    return ERR_INVALID_ARG;
+  }
+
+  switch (op) {
+    /* Argumente: ELEM_OP SET E */
+    case 'e':
+    case 'r':
+    case 'I':
+      if (count != 3) {
+        return ERR_WRONG_ARG_COUNT;
+      }
+      if (sscanf(tokens[2], "%ld%c", &e, &dummy) != 1) {
+        return ERR_INVALID_ELEMENT;
+      }
+      a = readOperand(session, tokens[1], target, op != 'e', &tempA, &error);
+      if (!error) {
+        switch (op) {
+          case 'e':
+            printf("%s%s\n", set_contains(a, e) ? "" : "no ", "element of set");
+            break;
+          case 'r':
+            result = set_remove(a, e);
+            a = EMPTY_SET;
+            hasResult = 1;
+            break;
+          case 'I':
+            result = set_insert(a, e);
+            a = EMPTY_SET;
+            hasResult = 1;
+            break;
+        }
+      }
+      break;
+    /* Argumente: UN_OP SET */
+    case 'o':
+    case 'R':
+    case 'C':
+    case 'M':
+    case 'm':
+    case 'c':
+      if (count != 2) {
+        return ERR_WRONG_ARG_COUNT;
+      }
+      a = readOperand(session, tokens[1], target, 0, &tempA, &error);
+      if (!error) {
+        switch (op) {
+          case 'o':
+            printSet(a);
+            break;
+          case 'R':
+            hasResult = 1;
+            break;
+          case 'C':
+            fprintf(stdout, "%lu\n", set_cardinality(a));
+            break;
+          case 'M':
+            if (! SET_IS_EMPTY(a)) {
+              fprintf(stdout, "%ld\n", set_max(a));
+            } else {
+              fprintf(stdout, "no maximum for empty list\n");
+            }
+            break;
+          case 'm':
+            if (! SET_IS_EMPTY(a)) {
+              fprintf(stdout, "%ld\n", set_min(a));
+            } else {
+              fprintf(stdout, "no minimum for empty list\n");
+            }
+            break;
+          case 'c':
+            result = set_copy(a);
+            hasResult = 1;
+            break;
+        }
+      }
+      break;
+    /* Argumente: W SET FILE */
+    case 'W':
+      if (count != 3) {
+        return ERR_WRONG_ARG_COUNT;
+      }
+      a = readOperand(session, tokens[1], target, 0, &tempA, &error);
+      if (!error) {
+        error = writeSetFile(a, tokens[2]);
+      }
+      break;
+    /* Argumente: BIN_OP SET1 SET2 */
+    case 's':
+    case '=':
+    case 'u':
+    case 'i':
+    case 'd':
+    case 'D':
+      if (count != 3) {
+        return ERR_WRONG_ARG_COUNT;
+      }
+      a = readOperand(session, tokens[1], target, 0, &tempA, &error);
+      if (!error) {
+        b = readOperand(session, tokens[2], target, 0, &tempB, &error);
+      }
+      if (!error) {
+        switch (op) {
+          case 's':
+            fprintf(stdout, "%s%s\n", set_is_subset(a, b) ? "" : "no ", "subset");
+            break;
+          case '=':
+            fprintf(stdout, "%s%s\n", set_equals(a, b) ? "" : "not ", "equal");
+            break;
+          case 'u':
+            result = set_union(a, b);
+            hasResult = 1;
+            break;
+          case 'i':
+            result = set_intersection(a, b);
+            hasResult = 1;
+            break;
+          case 'd':
+            result = set_difference(a, b);
+            hasResult = 1;
+            break;
+          case 'D':
+            result = set_symmetric_difference(a, b);
+            hasResult = 1;
+            break;
+        }
+      }
+      break;
+    default:
+      error = ERR_INVALID_ARG;
+  }
+
+  if (tempA) {
+    a = set_clear(a);
+  }
+  if (tempB) {
+    b = set_clear(b);
+  }
+
+  if (!error && hasResult) {
+    if (target != NULL) {
+      bind(session, target, result);
+    } else {
+      printSet(result);
+      result = set_clear(result);
+    }
+  }
+
+  return error;
+}
+
+/**
+ * Fuehrt die Befehle einer Sitzung zeilenweise aus. Fehlerhafte Befehle werden
+ * mit ihrer Zeilennummer gemeldet, die Sitzung laeuft danach weiter. Am Ende
+ * werden alle benannten Mengen freigegeben.
+ *
+ * @param[in] stream Datei bzw. Stream, aus dem die Befehle gelesen werden.
+ *
+ * @return der erste aufgetretene Fehlercode bzw. ERR_NULL.
+ */
+Errorcode
+runSession(FILE * stream) {
+  Errorcode 
+      error = ERR_NULL
+    , result = ERR_NULL
+    ;
+  Session 
+      session
+    ;
+  char 
+      * line = NULL
+    , * tokens[SESSION_MAX_TOKENS]
+    ;
+  size_t 
+      size = 0
+    ;
+  unsigned long 
+      number = 0
+    , i = 0
+    ;
+  int 
+      count = 0
+    ;
+
+  session.bindings = NULL;
+  session.count = 0;
+  session.size = 0;
+
+  while (readLine(stream, &line, &size)) {
+    number++;
+    count = splitLine(line, tokens);
+    if (count == 0 || (count > 0 && tokens[0][0] == '#')) {
+      continue;
+    }
+
+    error = count < 0 ? ERR_INVALID_SET_SYNTAX : runCommand(&session, tokens, count);
+    fflush(stdout);
+    if (error) {
+      fprintf(stderr, "line %lu: ", number);
+      printError(stderr, error);
+      if (!result) {
+        result = error;
+      }
+    }
+  }
+
+  for (i = 0; i < session.count; i++) {
+    session.bindings[i].set = set_clear(session.bindings[i].set);
+  }
+  free(session.bindings);
+  free(line);
+
+  return result;
 }
 
 /**
@@ -187,6 +956,10 @@ main (int argc, char * argv[]) {
     ;
   int 
       memory_management = 0
+    , statistics = 0
+    ;
+  SetShape
+      shape
     ;
  
   if (argc == 2 && (sscanf(argv[1], "-%c%c", &arg, &dummy) == 1) && arg == 'h') {    
@@ -194,7 +967,7 @@ main (int argc, char * argv[]) {
     return ERR_NULL;
   }
   
-  if (argc < 3) {
+  if (argc < 2) {
     error = ERR_WRONG_ARG_COUNT;
   }
   
@@ -204,10 +977,14 @@ main (int argc, char * argv[]) {
       error = ERR_INVALID_ARG;
     }
   }
+
+  if (!error && argc < 3 && op != 'S') {
+    error = ERR_WRONG_ARG_COUNT;
+  }
   
-  if (!error) {
+  if (!error && op != 'f' && op != 'S') {
     /* (erste) Menge einlesen */
-    s = readSet(argv[2], &error);
+    s = readSetArgument(argv[2], &error);
   }
   
   if (!error) {
@@ -223,8 +1000,8 @@ main (int argc, char * argv[]) {
         
         if (argc < 4 || argc > 5) { 
           error = ERR_WRONG_ARG_COUNT;
-        } else if (argc == 5 && ((sscanf(argv[4], "-%c%c", &arg, &dummy) == 1) && arg == 'm')) { 
-          memory_management = 1;
+        } else if (argc == 5) { 
+          readOption(argv[4], &memory_management, &statistics);
         }
         
         /* Element einlesen */
@@ -261,8 +1038,8 @@ main (int argc, char * argv[]) {
 
         if (argc < 3 || argc > 4) { 
           error = ERR_WRONG_ARG_COUNT;
-        } else if (argc == 4 && ((sscanf(argv[3], "-%c%c", &arg, &dummy) == 1) && arg == 'm')) { 
-          memory_management = 1;
+        } else if (argc == 4) { 
+          readOption(argv[3], &memory_management, &statistics);
         }
 
         if (!error) {
@@ -316,13 +1093,13 @@ main (int argc, char * argv[]) {
         
         if (argc < 4 || argc > 5) { 
           error = ERR_WRONG_ARG_COUNT;
-        } else if (argc == 5 && ((sscanf(argv[4], "-%c%c", &arg, &dummy) == 1) && arg == 'm')) {
-           memory_management = 1;
+        } else if (argc == 5) {
+           readOption(argv[4], &memory_management, &statistics);
         }
         
         if (!error) {
           /* zweite Menge einlesen */
-          s2 = readSet(argv[3], &error);
+          s2 = readSetArgument(argv[3], &error);
         }
         
         if (!error) {
@@ -355,11 +1132,68 @@ main (int argc, char * argv[]) {
         result = set_clear(result);
       }
       break;          
+      /* Argumente: W SET FILE */
+      case 'W':
+        if (argc < 4 || argc > 5) { 
+          error = ERR_WRONG_ARG_COUNT;
+        } else if (argc == 5) { 
+          readOption(argv[4], &memory_management, &statistics);
+        }
+
+        if (!error) {
+          error = writeSetFile(s, argv[3]);
+        }
+        break;
+      /* Argumente: f BIN_OP FILE1 FILE2 */
+      case 'f': {
+
+        char 
+            fileOp = '\0'
+          ;
+        int 
+            binary = 0
+          ;
+
+        if (argc < 5 || argc > 6) { 
+          error = ERR_WRONG_ARG_COUNT;
+        } else if (argc == 6) {
+          if (sscanf(argv[5], "-%c%c", &arg, &dummy) == 1 && arg == 'b') {
+            binary = 1;
+          } else {
+            readOption(argv[5], &memory_management, &statistics);
+          }
+        }
+
+        if (!error && sscanf(argv[2], "%c%c", &fileOp, &dummy) != 1) {
+          error = ERR_INVALID_ARG;
+        }
+
+        if (!error) {
+          error = streamFiles(fileOp, argv[3], argv[4], binary);
+        }
+      }
+      break;
+      /* Argumente: S */
+      case 'S':
+        if (argc > 3) { 
+          error = ERR_WRONG_ARG_COUNT;
+        } else if (argc == 3) {
+          readOption(argv[2], &memory_management, &statistics);
+        }
+
+        if (!error) {
+          error = runSession(stdin);
+        }
+        break;
       default:
         error = ERR_INVALID_ARG;
     }
   }
 
+  if (statistics) {
+    set_stats_shape(s, &shape);
+  }
+
   s = set_clear(s);
 
   if (memory_management) {
@@ -369,8 +1203,19 @@ main (int argc, char * argv[]) {
     fprintf(stderr, "SetListRefs: %d\n", setlist_refs);
   }
 
+  if (statistics) {
+    SetStats 
+        stats
+      ;
+
+    set_stats_get(&stats);
+    set_stats_print(stderr, &stats);
+    set_stats_print_shape(stderr, &shape);
+  }
+
   
-  if (error) {
+  /* die Fehler einer Sitzung wurden bereits zeilenweise gemeldet */
+  if (error && op != 'S') {
     printError (stderr, error);
     printUsage (stderr);
   }
@@ -5,14 +5,26 @@
  * 
  * @author Andre Kloodt, Alexander Loeffler
  * 
- * gcc -ansi -pedantic -Wall -Wextra -Werror -DMAX_PIXEL_COUNT=255 -o ueb02 error.c imaging.c ueb02.c
+ * gcc -ansi -pedantic -Wall -Wextra -Werror -o ueb02 error.c imaging.c ueb02.c
  */
 
 #include <assert.h>
 #include <ctype.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "imaging.h"
 
+/** size of the output buffer of imaging_writePGM */
+#define WRITE_BUFFER_SIZE 65536
+
+/** size of a value in the lookup table of imaging_writePGM: three digits and a blank */
+#define CELL_SIZE 4
+
+/** size of the input buffer of imaging_readPGM */
+#define READ_BUFFER_SIZE 65536
+
 
 
 Image imaging_createEmpty() 
@@ -21,26 +33,41 @@ Image imaging_createEmpty()
 
   new.height = 0;
   new.width = 0;
+  new.stride = 0;
+  new.pixels = NULL;
 
   return new;
 }
 
 
 
-Image imaging_create(unsigned int width, unsigned int height, Grayscale background) 
+Errorcode imaging_create(Image * img, unsigned int width, unsigned int height, Grayscale background) 
 {
-  unsigned int i = 0;
-  Image new;
-  assert (width*height <= MAX_PIXEL_COUNT);
+  size_t size = (size_t) width * height;
+  assert (img != NULL);
 
-  new.height = height;
-  new.width = width;
-  
-  for(i = 0; i < width*height; i++)
+  (*img) = imaging_createEmpty();
+
+  /** the pixel count must fit into size_t */
+  if(height != 0 && size / height != width)
   {
-	  new.pixels[i] = background;  
+    return ERR_IMAGE_SIZE;
   }
-  return new;
+  if(size > 0)
+  {
+    (*img).pixels = malloc(size);
+    if((*img).pixels == NULL)
+    {
+      return ERR_IMAGE_SIZE;
+    }
+    memset((*img).pixels, background, size);
+  }
+
+  (*img).height = height;
+  (*img).width = width;
+  (*img).stride = width;
+
+  return ERR_NULL;
 }
 
 
@@ -49,32 +76,57 @@ void imaging_delete(Image * img)
 {
   assert (img != NULL);
   
-  (*img).height = 0;
-  (*img).width = 0;
+  free((*img).pixels);
+  (*img) = imaging_createEmpty();
+}
+
+
+
+unsigned int imaging_getWidth(const Image * img) 
+{
+  assert (img != NULL);
+
+  return (*img).width;
+}
+
+
+
+unsigned int imaging_getHeight(const Image * img) 
+{
+  assert (img != NULL);
+
+  return (*img).height;
 }
 
 
 
-unsigned int imaging_getWidth(Image img) 
+Grayscale imaging_getGrayscaleAt(const Image * img, unsigned int x, unsigned int y) 
 {
-  return img.width;
+  assert (img != NULL);
+  assert (x < (*img).width);
+  assert (y < (*img).height);
+
+  return (*img).pixels[y*(*img).stride+x];
 }
 
 
 
-unsigned int imaging_getHeight(Image img) 
+const Grayscale * imaging_getRow(const Image * img, unsigned int y) 
 {
-  return img.height;
+  assert (img != NULL);
+  assert (y < (*img).height);
+
+  return (*img).pixels + y*(*img).stride;
 }
 
 
 
-Grayscale imaging_getGrayscaleAt(Image img, unsigned int x, unsigned int y) 
+Grayscale * imaging_getRowMutable(Image * img, unsigned int y) 
 {
-  assert (x < img.width);
-  assert (y < img.height);
+  assert (img != NULL);
+  assert (y < (*img).height);
 
-  return img.pixels[y*img.width+x];
+  return (*img).pixels + y*(*img).stride;
 }
 
 
@@ -85,7 +137,60 @@ void imaging_setGrayscaleAt(Image * img, unsigned int x, unsigned int y, Graysca
   assert (x < (*img).width);
   assert (y < (*img).height);
  
-  (*img).pixels[y*(*img).width+x] = gray;    
+  (*img).pixels[y*(*img).stride+x] = gray;    
+}
+
+
+
+void imaging_tile(Image * img, const Image * source, unsigned int x, unsigned int y,
+                  unsigned int width, unsigned int height,
+                  unsigned int offsetX, unsigned int offsetY)
+{
+  unsigned int row = 0,
+               phase = 0;
+  size_t filled = 0,
+         chunk = 0;
+  Grayscale * target = NULL;
+  const Grayscale * tile = NULL;
+
+  assert (img != NULL);
+  assert (source != NULL);
+  assert (img != source);
+  assert (width > 0 && x <= (*source).width && width <= (*source).width - x);
+  assert (height > 0 && y <= (*source).height && height <= (*source).height - y);
+
+  if((*img).width == 0)
+  {
+    return;
+  }
+  phase = offsetX % width;
+
+  /** the first tile row span of every row, rotated by the offset, is doubled
+   *  by copying the part already written until the row is full */
+  for(row = 0; row < (*img).height && row < height; row++)
+  {
+    target = imaging_getRowMutable(img, row);
+    tile = imaging_getRow(source, y + (unsigned int) (((unsigned long) row + offsetY) % height)) + x;
+
+    filled = width - phase < (*img).width ? width - phase : (*img).width;
+    memcpy(target, tile + phase, filled);
+    chunk = phase < (*img).width - filled ? phase : (*img).width - filled;
+    memcpy(target + filled, tile, chunk);
+    filled += chunk;
+
+    while(filled < (*img).width)
+    {
+      chunk = filled < (*img).width - filled ? filled : (*img).width - filled;
+      memcpy(target + filled, target, chunk);
+      filled += chunk;
+    }
+  }
+
+  /** every further row repeats the row one tile height above */
+  for(; row < (*img).height; row++)
+  {
+    memcpy(imaging_getRowMutable(img, row), imaging_getRow(img, row - height), (*img).width);
+  }
 }
 
 
@@ -96,16 +201,22 @@ void imaging_setGrayscaleAt(Image * img, unsigned int x, unsigned int y, Graysca
  * 
  * @return the length of the higest value
 */
-unsigned char biggest_Grayscale(Image img)
+unsigned char biggest_Grayscale(const Image * img)
 {
-  unsigned char bigGray, bigDigitCount = 0;
-  unsigned int i = 0;
+  unsigned char bigGray = 0, bigDigitCount = 0;
+  unsigned int x = 0,
+               y = 0;
+  const Grayscale * row = NULL;
  
-  for(i = 0; i < (img.height)*(img.width); i++)
+  for(y = 0; y < (*img).height; y++)
   {
-    if(img.pixels[i] > bigGray)
+    row = imaging_getRow(img, y);
+    for(x = 0; x < (*img).width; x++)
     {
-      bigGray = img.pixels[i];
+      if(row[x] > bigGray)
+      {
+        bigGray = row[x];
+      }
     }
   }
   if(bigGray >= 100)
@@ -151,117 +262,446 @@ unsigned char grayScale_Length(unsigned char value){
 }
 
 
-Errorcode imaging_writePGM(Image img, FILE * stream, unsigned int * bytesWritten) 
+/** write the filled part of the output buffer of imaging_writePGM
+ * 
+ * @param stream the stream
+ * @param buffer the buffer
+ * @param fill the number of bytes in the buffer, set to 0
+ * @param total the number of bytes written so far, increased by fill
+ * 
+ * @return 1 if all bytes were written, 0 otherwise
+*/
+int flush_Buffer(FILE * stream, const char * buffer, size_t * fill, unsigned long * total)
+{
+  if(fwrite(buffer, 1, (*fill), stream) != (*fill))
+  {
+    return 0;
+  }
+  (*total) += (*fill);
+  (*fill) = 0;
+  return 1;
+}
+
+
+Errorcode imaging_writePGM(const Image * img, FILE * stream, unsigned long * bytesWritten) 
 {
-  unsigned int x = 1,
+  char buffer[WRITE_BUFFER_SIZE];
+  char cells[256][CELL_SIZE];
+  unsigned int x = 0,
                y = 0,
-               z = 0,
-               a = 0,
-               tempBytes = 0;
-  Errorcode err = ERR_NULL;
-  unsigned char biggestGrey = biggest_Grayscale(img);
-  unsigned int * tempWritten = &a;
+               value = 0,
+               digit = 0;
+  unsigned char biggestGrey = 0,
+                length = 0;
+  size_t fill = 0;
+  unsigned long total = 0;
+  int headerBytes = 0;
+  const Grayscale * row = NULL;
 
+  assert (img != NULL);
   assert (stream != NULL);
   assert (bytesWritten != NULL);
 
-  if(((*tempWritten) = fprintf(stream,"%s\n%d %d\n%d\n","P2",img.width,img.height,255)) > 0){
-    (*bytesWritten) = (*tempWritten);
+  biggestGrey = biggest_Grayscale(img);
 
-  for(y = 0;y < img.height*img.width; y++) 
-  {  
-    tempBytes = imaging_getGrayscaleAt(img,(y-z*img.width),z);
-    /** sub the biggest GrayscaleValue and the current */
-    if(biggestGrey - grayScale_Length(tempBytes) == 2)
+  /** every value takes biggestGrey digits, right aligned, and a following blank */
+  for(value = 0; value < 256; value++)
+  {
+    memset(cells[value], ' ', CELL_SIZE);
+    length = grayScale_Length(value);
+    if(length <= biggestGrey)
     {
-      if(((*tempWritten) = fprintf(stream,"  ")) > 0){
-        (*bytesWritten) += (*tempWritten);
+      for(digit = value, x = biggestGrey; x > (unsigned int) (biggestGrey - length); x--)
+      {
+        cells[value][x - 1] = (char) ('0' + digit % 10);
+        digit /= 10;
       }
-	  }
-	  else if (biggestGrey - grayScale_Length(tempBytes) == 1)
-	  {
-      if(((*tempWritten) = fprintf(stream," ")) > 0){
-        (*bytesWritten) += (*tempWritten);
+    }
+  }
+
+  headerBytes = fprintf(stream,"%s\n%u %u\n%d\n","P2",(*img).width,(*img).height,255);
+  if(headerBytes < 0)
+  {
+    return ERR_FILE_WRITE;
+  }
+  total = (unsigned long) headerBytes;
+
+  for(y = 0; y < (*img).height; y++)
+  {
+    row = imaging_getRow(img, y);
+    for(x = 0; x < (*img).width; x++)
+    {
+      /** room for a whole cell */
+      if(fill + CELL_SIZE > WRITE_BUFFER_SIZE && !flush_Buffer(stream, buffer, &fill, &total))
+      {
+        return ERR_FILE_WRITE;
       }
-	  }
-    /** set the value with a following letter blank */
-    if(((*tempWritten) = fprintf(stream,"%d ",tempBytes)) > 0){
-      (*bytesWritten) += (*tempWritten);
+      memcpy(buffer + fill, cells[row[x]], CELL_SIZE);
+      fill += biggestGrey + 1;
+    }
+    if(fill + 1 > WRITE_BUFFER_SIZE && !flush_Buffer(stream, buffer, &fill, &total))
+    {
+      return ERR_FILE_WRITE;
     }
+    buffer[fill++] = '\n';
+  }
+  if(!flush_Buffer(stream, buffer, &fill, &total))
+  {
+    return ERR_FILE_WRITE;
+  }
+
+  (*bytesWritten) = total;
+  return ERR_NULL;
+}
+
+
+Errorcode imaging_writePGMBinary(const Image * img, FILE * stream, unsigned long * bytesWritten) 
+{
+  int headerBytes = 0;
+  unsigned int y = 0;
+  size_t rasterBytes = 0,
+         written = 0;
 
-    if(y == img.width*x-1)
+  assert (img != NULL);
+  assert (stream != NULL);
+  assert (bytesWritten != NULL);
+
+  headerBytes = fprintf(stream,"%s\n%u %u\n%d\n","P5",(*img).width,(*img).height,255);
+  if(headerBytes < 0)
+  {
+    return ERR_FILE_WRITE;
+  }
+
+  rasterBytes = (size_t) (*img).width * (*img).height;
+  if(rasterBytes > 0 && (*img).stride == (*img).width)
+  {
+    /** the rows are contiguous, write the whole raster at once */
+    written = fwrite((*img).pixels, 1, rasterBytes, stream);
+  }
+  else
+  {
+    for(y = 0; y < (*img).height; y++)
     {
-      (*tempWritten) = fprintf(stream,"\n");
-      if((*tempWritten) > 0){
-        (*bytesWritten) += (*tempWritten);
+      written += fwrite(imaging_getRow(img, y), 1, (*img).width, stream);
+    }
+  }
+  if(written != rasterBytes)
+  {
+    return ERR_FILE_WRITE;
+  }
+
+  (*bytesWritten) = (unsigned long) headerBytes + rasterBytes;
+  return ERR_NULL;
+}
+
+
+/** buffered input of imaging_readPGM */
+typedef struct {
+  FILE * stream;
+  unsigned char buffer[READ_BUFFER_SIZE];
+  /** next byte to read */
+  size_t pos;
+  /** number of valid bytes in the buffer */
+  size_t fill;
+} PGMReader;
+
+/** whitespace in the C locale, like isspace */
+#define IS_SPACE(C) ((C) == ' ' || ((C) >= '\t' && (C) <= '\r'))
+
+/** digit */
+#define IS_DIGIT(C) ((C) >= '0' && (C) <= '9')
+
+/** next byte of a reader without consuming it, the buffer is only refilled when empty */
+#define READER_PEEK(READER) ((*(READER)).pos < (*(READER)).fill ? \
+                             (int) (*(READER)).buffer[(*(READER)).pos] : reader_Peek(READER))
+
+
+/** refill the buffer of the reader if it is empty and return the next byte
+ * without consuming it
+ * 
+ * @param reader the reader
+ * 
+ * @return the next byte, EOF at the end of the stream
+*/
+int reader_Peek(PGMReader * reader)
+{
+  if((*reader).pos == (*reader).fill)
+  {
+    (*reader).fill = fread((*reader).buffer, 1, READ_BUFFER_SIZE, (*reader).stream);
+    (*reader).pos = 0;
+    if((*reader).fill == 0)
+    {
+      return EOF;
+    }
+  }
+  return (*reader).buffer[(*reader).pos];
+}
+
+
+/** skip whitespace and comments (from # to the end of the line)
+ * 
+ * @param reader the reader
+*/
+void reader_SkipSpace(PGMReader * reader)
+{
+  int c = READER_PEEK(reader);
+
+  while(c != EOF && (isspace(c) || c == '#'))
+  {
+    if(c == '#')
+    {
+      while(c != EOF && c != '\n' && c != '\r')
+      {
+        (*reader).pos++;
+        c = READER_PEEK(reader);
+      }
+    }
+    else
+    {
+      (*reader).pos++;
+      c = READER_PEEK(reader);
+    }
+  }
+}
+
+
+/** read an unsigned decimal number behind whitespace and comments, the number
+ * must be followed by whitespace, a comment or the end of the stream
+ * 
+ * @param reader the reader
+ * @param limit the biggest valid value
+ * @param value the number
+ * 
+ * @return 1 if a valid number was read, 0 at the end of the stream,
+ *         -1 if the next token is no number or bigger than limit
+*/
+int reader_Number(PGMReader * reader, unsigned long limit, unsigned long * value)
+{
+  int c = 0,
+      valid = 1;
+  unsigned long digits = 0,
+                digit = 0;
+
+  reader_SkipSpace(reader);
+
+  (*value) = 0;
+  while((c = READER_PEEK(reader)) != EOF && c >= '0' && c <= '9')
+  {
+    digit = (unsigned long) (c - '0');
+    if((*value) > (limit - digit) / 10)
+    {
+      valid = 0;
+    }
+    else
+    {
+      (*value) = (*value) * 10 + digit;
+    }
+    (*reader).pos++;
+    digits++;
+  }
+
+  if(digits == 0)
+  {
+    return c == EOF ? 0 : -1;
+  }
+  if(c != EOF && !isspace(c) && c != '#')
+  {
+    return -1;
+  }
+  return valid ? 1 : -1;
+}
+
+
+/** read the ASCII raster (P2) of an image whose header was read already
+ * 
+ * @param img the created image
+ * @param reader the reader, positioned behind the maximum gray value
+ * 
+ * @return ERR_NULL, ERR_PGM_INVALID_DATA if a value is invalid,
+ *         ERR_IMAGE_SIZE if values are missing
+*/
+Errorcode read_AsciiRaster(Image * img, PGMReader * reader)
+{
+  unsigned int x = 0,
+               y = 0;
+  unsigned long greyValue = 0;
+  int result = 0;
+  Grayscale * row = NULL;
+  const unsigned char * p = NULL,
+                      * limit = NULL;
+
+  for(y = 0; y < (*img).height; y++)
+  {
+    row = imaging_getRowMutable(img, y);
+    for(x = 0; x < (*img).width; x++)
+    {
+      /** fast path inside the buffer: blanks, up to three digits and a
+       *  separating blank, everything else (comments, buffer end) is left
+       *  to reader_Number */
+      if((*reader).fill - (*reader).pos > 4)
+      {
+        p = (*reader).buffer + (*reader).pos;
+        limit = (*reader).buffer + (*reader).fill - 4;
+        while(p < limit && IS_SPACE(*p))
+        {
+          p++;
+        }
+        (*reader).pos = (size_t) (p - (*reader).buffer);
+        if(p < limit && IS_DIGIT(*p))
+        {
+          greyValue = (unsigned long) (*p++ - '0');
+          if(IS_DIGIT(*p))
+          {
+            greyValue = greyValue * 10 + (unsigned long) (*p++ - '0');
+            if(IS_DIGIT(*p))
+            {
+              greyValue = greyValue * 10 + (unsigned long) (*p++ - '0');
+            }
+          }
+          if(greyValue <= 255 && (IS_SPACE(*p) || *p == '#'))
+          {
+            row[x] = (Grayscale) greyValue;
+            (*reader).pos = (size_t) (p - (*reader).buffer);
+            continue;
+          }
+        }
+      }
+
+      result = reader_Number(reader, 255, &greyValue);
+      if(result == 0)
+      {
+        return ERR_IMAGE_SIZE;
+      }
+      if(result < 0)
+      {
+        return ERR_PGM_INVALID_DATA;
       }
-      x++;
-      z++;
+      row[x] = (Grayscale) greyValue;
     }
   }
-  }    
-	return err;
+  return ERR_NULL;
+}
+
+
+/** read bytes from the reader, first from its buffer, then directly from the stream
+ * 
+ * @param reader the reader
+ * @param target the target
+ * @param count the number of bytes
+ * 
+ * @return the number of bytes read
+*/
+size_t reader_Read(PGMReader * reader, Grayscale * target, size_t count)
+{
+  size_t buffered = (*reader).fill - (*reader).pos;
+
+  if(buffered > count)
+  {
+    buffered = count;
+  }
+  memcpy(target, (*reader).buffer + (*reader).pos, buffered);
+  (*reader).pos += buffered;
+
+  return buffered + fread(target + buffered, 1, count - buffered, (*reader).stream);
+}
+
+
+/** read the binary raster (P5) of an image whose header was read already
+ * 
+ * @param img the created image
+ * @param reader the reader, positioned behind the maximum gray value
+ * 
+ * @return ERR_NULL, ERR_PGM_INVALID_HEAD if the header does not end with a
+ *         single whitespace, ERR_IMAGE_SIZE if the raster is too short
+*/
+Errorcode read_BinaryRaster(Image * img, PGMReader * reader)
+{
+  unsigned int y = 0;
+  size_t rasterBytes = (size_t) (*img).width * (*img).height,
+         read = 0;
+  int c = READER_PEEK(reader);
+
+  /** exactly one whitespace separates the header from the raster */
+  if(c == EOF || !isspace(c))
+  {
+    return ERR_PGM_INVALID_HEAD;
+  }
+  (*reader).pos++;
+
+  if((*img).stride == (*img).width)
+  {
+    /** the rows are contiguous, read the whole raster at once */
+    read = reader_Read(reader, (*img).pixels, rasterBytes);
+  }
+  else
+  {
+    for(y = 0; y < (*img).height; y++)
+    {
+      read += reader_Read(reader, imaging_getRowMutable(img, y), (*img).width);
+    }
+  }
+  return read == rasterBytes ? ERR_NULL : ERR_IMAGE_SIZE;
 }
 
 
 Errorcode imaging_readPGM(Image * img, FILE * stream) 
 {
   Errorcode err = ERR_NULL;
-  unsigned char str1 = '\0',
-                str2 = '\0';
-  int tempWidth = 0,
-      tempHeight = 0,
-      lightValue = 0,
-      greyValue = 0,
-      x = 0,
-      y = 0;
+  PGMReader * reader = NULL;
+  int str1 = '\0',
+      str2 = '\0',
+      next = '\0';
+  unsigned long tempWidth = 0,
+                tempHeight = 0,
+                lightValue = 0;
 
 	assert (stream != NULL);
   assert (img != NULL);
+
+  reader = malloc(sizeof(PGMReader));
+  if(reader == NULL)
+  {
+    return ERR_IMAGE_SIZE;
+  }
+  (*reader).stream = stream;
+  (*reader).pos = 0;
+  (*reader).fill = 0;
+
+  str1 = READER_PEEK(reader);
+  (*reader).pos += str1 != EOF;
+  str2 = READER_PEEK(reader);
+  (*reader).pos += str2 != EOF;
+  next = READER_PEEK(reader);
     
-  /** check the first line, if P2 */
-  if(fscanf(stream,"%c%c",&str1,&str2) != 2 || str1 != 'P' || str2 != '2')
+  /** check the first line, if P2 (ASCII) or P5 (binary), followed by whitespace */
+  if(str1 != 'P' || (str2 != '2' && str2 != '5') || (next != EOF && !isspace(next) && next != '#'))
   {     
     err = ERR_PGM_INVALID_HEAD;
   }
   /** check the secound line, the Width and Height value */
-  else if(fscanf(stream,"%d%d",&tempWidth,&tempHeight) != 2 || tempWidth*tempHeight > MAX_PIXEL_COUNT || 
-          tempWidth <= 0 || tempHeight <= 0)
+  else if(reader_Number(reader, UINT_MAX, &tempWidth) != 1 || reader_Number(reader, UINT_MAX, &tempHeight) != 1 ||
+          tempWidth == 0 || tempHeight == 0)
   {
     err = ERR_PGM_INVALID_HEAD;
   }
   /** check the third line, if the light value is 255 */ 
-  else if(fscanf(stream,"%d",&lightValue) != 1 || lightValue != 255)
+  else if(reader_Number(reader, 65535, &lightValue) != 1 || lightValue != 255)
   {
     err = ERR_PGM_INVALID_HEAD;
   }
+  else if(imaging_create(img, tempWidth, tempHeight, 0) != ERR_NULL)
+  {
+    err = ERR_IMAGE_SIZE;
+  }
+  else if(str2 == '5')
+  {
+    err = read_BinaryRaster(img, reader);
+  }
   else
   {  
-    (*img) = imaging_create(tempWidth, tempHeight, 0);
-    /** fill a new array with the new greyValues */
-    while(x < tempWidth*tempHeight)
-    {        
-      if(fscanf(stream,"%d",&greyValue) != 1)
-      {
-        err = ERR_PGM_INVALID_DATA;
-      }
-      else if(greyValue < 0 || greyValue > 255 )
-      {
-        err = ERR_PGM_INVALID_DATA;
-      }
-      else
-      {
-        (*img).pixels[x] = greyValue;
-        y++;
-      }         
-      x++;
-    }
-
-    if(x != y){
-      err = ERR_IMAGE_SIZE;
-    }
-
+    err = read_AsciiRaster(img, reader);
   }
+
+  free(reader);
   return err;
 }
- 
@@ -12,13 +12,9 @@
  */
 
 #include <stdio.h>
+#include <stddef.h>
 #include "error.h"
 
-/* Sofern nicht vom Compiler festgelegt, definiere eine maximale Laenge */
-#ifndef MAX_PIXEL_COUNT
-#define MAX_PIXEL_COUNT 10000
-#endif
-
 /** 
  *  Typdefintion fuer Graustufen
  */
@@ -27,11 +23,19 @@ typedef unsigned char Grayscale;
 
 /**
  *  Typdefinition und Struktur fuer Bilder. 
+ *
+ *  Die Pixel liegen zeilenweise in einem Speicherbereich auf dem Heap, der mit
+ *  imaging_create angelegt und mit imaging_delete freigegeben wird. Zeile y
+ *  beginnt bei pixels + y * stride. Bilder werden per Zeiger uebergeben, ein
+ *  Zugriff kopiert also keine Pixel.
  */
 typedef struct {
   unsigned int width;
   unsigned int height;
-  Grayscale pixels[MAX_PIXEL_COUNT];
+  /** Abstand zweier Zeilen in Pixeln (mindestens width) */
+  size_t stride;
+  /** die Pixel, NULL bei einem leeren Bild */
+  Grayscale * pixels;
 } Image;
 
 /**
@@ -43,20 +47,25 @@ Image imaging_createEmpty();
   
 /**
  * Erzeugt ein Bild mit den uebergebenen Abmessungen (Breite, Hoehe) in
- * der angegegebenen Hintergrundfarbe.
+ * der angegegebenen Hintergrundfarbe. Der Speicher der Pixel wird auf dem
+ * Heap angelegt und muss mit imaging_delete freigegeben werden.
  *
+ * @param img Zeiger auf das zu erzeugende Bild.
  * @param width Die Breite des zu erzeugenden Bildes
  * @param height Die Hoehe des zu erzeugenden Bildes
  * @param background Hintergrundfarbe.
  *
- * @pre width*height <= MAX_PIXEL_COUNT
+ * @pre img != NULL
  *
- * @return Das neu erzeugte Bild.
+ * @return Errorcode ERR_NULL, wenn alles ok war
+ *                   ERR_IMAGE_SIZE, wenn der Speicher fuer die Pixel nicht
+ *                                   angelegt werden konnte (img ist dann leer)
  */
-Image imaging_create(unsigned int width, unsigned int height, Grayscale background);
+Errorcode imaging_create(Image * img, unsigned int width, unsigned int height, Grayscale background);
 
 /**
- * Loescht ein Bild, indem die Abmessungen auf 0 gesetzt werden.
+ * Loescht ein Bild, indem der Speicher der Pixel freigegeben wird und die
+ * Abmessungen auf 0 gesetzt werden.
  *
  * @param img Das zu loeschende Bild.
  * @pre img != NULL
@@ -69,19 +78,21 @@ void imaging_delete(Image * img);
  * Liefert die Breite des uebergebenen Bildes.
  *
  * @param img Das Bild.
+ * @pre img != NULL
  *
  * @return Die Breite des Bildes.
  */
-unsigned int imaging_getWidth(Image img);
+unsigned int imaging_getWidth(const Image * img);
 
 /**
  * Liefert die Hoehe des uebergebenen Bildes.
  *
  * @param img Das Bild.
+ * @pre img != NULL
  *
  * @return Die Hoehe des Bildes.
  */
-unsigned int imaging_getHeight(Image img);
+unsigned int imaging_getHeight(const Image * img);
 
 /**
  * Ermittelt den Grauwert an der uebergebenen Stelle des uebergebenen Bildes.
@@ -90,12 +101,41 @@ unsigned int imaging_getHeight(Image img);
  * @param x Die X-Koordinate.
  * @param y Die Y-Koordinate.
  *
+ * @pre img != NULL
  * @pre x < Bildbreite
  * @pre y < Bildhoehe
  *
  * @return Die ermittelte Graustufe.
  */
-Grayscale imaging_getGrayscaleAt(Image img, unsigned int x, unsigned int y);
+Grayscale imaging_getGrayscaleAt(const Image * img, unsigned int x, unsigned int y);
+
+/**
+ * Liefert den Anfang einer Zeile des uebergebenen Bildes zum Lesen. Die Zeile
+ * umfasst Bildbreite viele Pixel.
+ *
+ * @param img Das Bild.
+ * @param y Die Y-Koordinate.
+ *
+ * @pre img != NULL
+ * @pre y < Bildhoehe
+ *
+ * @return Zeiger auf das erste Pixel der Zeile.
+ */
+const Grayscale * imaging_getRow(const Image * img, unsigned int y);
+
+/**
+ * Liefert den Anfang einer Zeile des uebergebenen Bildes zum Schreiben. Die
+ * Zeile umfasst Bildbreite viele Pixel.
+ *
+ * @param img Das Bild.
+ * @param y Die Y-Koordinate.
+ *
+ * @pre img != NULL
+ * @pre y < Bildhoehe
+ *
+ * @return Zeiger auf das erste Pixel der Zeile.
+ */
+Grayscale * imaging_getRowMutable(Image * img, unsigned int y);
 
 /**
  * Setzt einen Grauwert an der uebergebenen Stelle des uebergebenen Bildes.
@@ -111,6 +151,32 @@ Grayscale imaging_getGrayscaleAt(Image img, unsigned int x, unsigned int y);
  */
 void imaging_setGrayscaleAt(Image * img, unsigned int x, unsigned int y, Grayscale gray);
 
+/**
+ * Fuellt das Bild img mit Kacheln aus einem Ausschnitt des Bildes source.
+ * Der Ausschnitt beginnt bei (x, y) und ist width Pixel breit und height Pixel
+ * hoch. Das Pixel (u, v) von img erhaelt den Grauwert des Ausschnitts an der
+ * Stelle ((u + offsetX) mod width, (v + offsetY) mod height), die Kacheln sind
+ * also um (offsetX, offsetY) verschoben.
+ *
+ * @param img Das zu fuellende Bild.
+ * @param source Das Bild mit dem Ausschnitt.
+ * @param x Die X-Koordinate des Ausschnitts.
+ * @param y Die Y-Koordinate des Ausschnitts.
+ * @param width Die Breite des Ausschnitts.
+ * @param height Die Hoehe des Ausschnitts.
+ * @param offsetX Die Verschiebung der Kacheln in X-Richtung.
+ * @param offsetY Die Verschiebung der Kacheln in Y-Richtung.
+ *
+ * @pre img != NULL
+ * @pre source != NULL
+ * @pre img != source
+ * @pre 0 < width und x + width <= Breite von source
+ * @pre 0 < height und y + height <= Hoehe von source
+ */
+void imaging_tile(Image * img, const Image * source, unsigned int x, unsigned int y,
+                  unsigned int width, unsigned int height,
+                  unsigned int offsetX, unsigned int offsetY);
+
 /**
  * Schreibt das uebergebene Bild in den uebergebenen Stream (z.B. eine Datei). 
  * Dabei wird zusaetzlich die Groesse des geschriebenen Dateistroms ermittelt 
@@ -120,25 +186,58 @@ void imaging_setGrayscaleAt(Image * img, unsigned int x, unsigned int y, Graysca
  *
  * Das Bild wird im Format P2 als PGM (Portable Graymap ASCII) geschrieben mit
  * einem Wert fuer die maximale Helligkeit von 255. 
- * Die Ausgabe der Bilddaten erfolgt zeilenweise und rechtsbuendig.
+ * Die Ausgabe der Bilddaten erfolgt zeilenweise und rechtsbuendig. Die Zeilen
+ * werden ueber eine Tabelle der Textdarstellungen aller Grauwerte in einem
+ * Puffer aufgebaut, der blockweise geschrieben wird.
  *
  * @param img Das Bild.
  * @param stream Der Stream.
  * @param bytesWritten Zeiger auf die Anzahl der Bytes, die in die Dateistrom geschrieben 
  *                     wurden (Dateigroesse).
  *
+ * @pre img != NULL
+ * @pre stream != NULL
+ * @pre bytesWritten != NULL
+ *
+ * @return Errorcode ERR_NULL, wenn alles ok war
+ *                   ERR_FILE_WRITE, falls nicht in den Dateistrom geschrieben werden konnte
+ */
+Errorcode imaging_writePGM(const Image * img, FILE * stream, unsigned long * bytesWritten);
+
+/**
+ * Schreibt das uebergebene Bild im Format P5 als PGM (Portable Graymap binaer)
+ * mit einem Wert fuer die maximale Helligkeit von 255 in den uebergebenen
+ * Stream. Auf den Kopf folgen die Grauwerte zeilenweise als je ein Byte, bei
+ * zusammenhaengenden Zeilen mit einem einzigen fwrite. Die Groesse des
+ * geschriebenen Dateistroms wird ueber bytesWritten zurueckgegeben, bei einem
+ * Fehler bleibt der Wert unveraendert.
+ *
+ * @param img Das Bild.
+ * @param stream Der Stream (im Binaermodus geoeffnet).
+ * @param bytesWritten Zeiger auf die Anzahl der Bytes, die in die Dateistrom geschrieben 
+ *                     wurden (Dateigroesse).
+ *
+ * @pre img != NULL
  * @pre stream != NULL
  * @pre bytesWritten != NULL
  *
  * @return Errorcode ERR_NULL, wenn alles ok war
  *                   ERR_FILE_WRITE, falls nicht in den Dateistrom geschrieben werden konnte
  */
-Errorcode imaging_writePGM(Image img, FILE * stream, unsigned int * bytesWritten);
+Errorcode imaging_writePGMBinary(const Image * img, FILE * stream, unsigned long * bytesWritten);
 
 
 /**
- * Liest ein PGM Bild im ASCII Format (P2) aus dem uebergebenen Dateistrom. Es
- * werden nur Bilder akzeptiert, deren Wert fuer die maximale Helligkeit 255 ist.
+ * Liest ein PGM Bild im ASCII Format (P2) oder im Binaerformat (P5) aus dem
+ * uebergebenen Dateistrom, das Format wird am Kopf erkannt. Es werden nur
+ * Bilder akzeptiert, deren Wert fuer die maximale Helligkeit 255 ist. Zwischen
+ * den Zahlen darf beliebiger Whitespace und Kommentare (von # bis zum
+ * Zeilenende) stehen. Die Datei wird blockweise gelesen und die Zahlen ohne
+ * fscanf zerlegt. Im Binaerformat werden die Grauwerte mit einem einzigen
+ * fread gelesen.
+ * Das Bild wird mit imaging_create angelegt und ist vom Aufrufer mit
+ * imaging_delete freizugeben, auch wenn die Bilddaten ungueltig waren. Ein
+ * zuvor in img gespeichertes Bild wird dabei nicht freigegeben.
  *
  * @param img Zeiger auf das Bild.
  * @param stream Der Dateistrom.
@@ -148,10 +247,10 @@ Errorcode imaging_writePGM(Image img, FILE * stream, unsigned int * bytesWritten
  *
  * @return Errorcode ERR_NULL, wenn alles ok war
  *                   ERR_PPM_INVALID_HEAD, wenn der PGM Header ungueltig war
- *                   ERR_PPM_INVALID_DATA, wenn die Bilddaten ungueltig waren
+ *                   ERR_PPM_INVALID_DATA, wenn ein Grauwert ungueltig war
  *                   ERR_IMAGE_SIZE, wenn das Bild in der Datei zu gross ist
  *                                   um gespeichert werden zu koennen 
- *                                   (Arraygroesse)
+ *                                   (Speicher) oder zu wenige Bilddaten enthaelt
  */
 Errorcode imaging_readPGM(Image * img, FILE * stream);
 
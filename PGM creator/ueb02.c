@@ -8,6 +8,8 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 
 #include "error.h"
@@ -53,9 +55,11 @@ void printUsage(FILE *stream)
   fprintf(stream, "%s\n", "    -o FILE");
   fprintf(stream, "%s\n", "       -> Output the current image into FILE");
   fprintf(stream, "%s\n", "          and print the amount of written bytes to stdout.");
+  fprintf(stream, "%s\n", "    -O FILE");
+  fprintf(stream, "%s\n", "       -> Like -o, but write a binary PGM (P5).");
   fprintf(stream, "%s\n", "    -r FILE");
-  fprintf(stream, "%s\n", "       -> Read an image from the given FILE and write it repeatedly");
-  fprintf(stream, "%s\n", "          into the current image.");
+  fprintf(stream, "%s\n", "       -> Read an image (ASCII P2 or binary P5) from the given FILE");
+  fprintf(stream, "%s\n", "          and write it repeatedly into the current image.");
   fprintf(stream, "%s\n", "");
 }
 
@@ -151,12 +155,65 @@ int checkArgImageInput(char *argv[])
   {
     err = ERR_INVALID_ARG;
   }
-  else if (convertToInt(argv[1]) * convertToInt(argv[2]) > MAX_PIXEL_COUNT)
+
+  return err;
+}
+
+
+
+/** bytes blended at once by blendRow */
+#define BLEND_WORD sizeof(unsigned long)
+
+/**
+ * Sets the stripes of one row: lineWidth pixels, then lineSpace pixels left
+ * as they are, starting with a stripe at x = 0.
+ *
+ * @param[in,out] row, the row
+ * @param[in] width, the row length
+ * @param[in] lineWidth
+ * @param[in] lineSpace
+ * @param[in] grey, the grey value
+ */
+static void fillStripes(Grayscale * row, unsigned int width, unsigned int lineWidth, unsigned int lineSpace, unsigned char grey)
+{
+  unsigned long x = 0;
+  unsigned long period = (unsigned long) lineWidth + lineSpace;
+
+  for(; x < width; x += period)
   {
-    err = ERR_IMAGE_SIZE;
+    memset(row + x, grey, lineWidth < width - x ? lineWidth : width - x);
   }
+}
 
-  return err;
+
+
+/**
+ * Blends grey into a row wherever the mask is set, a machine word at a time.
+ *
+ * @param[in,out] row, the row
+ * @param[in] mask, 0xFF for stripe pixels, 0 for the others
+ * @param[in] width, the row length
+ * @param[in] grey, the grey value
+ */
+static void blendRow(Grayscale * row, const Grayscale * mask, unsigned int width, unsigned char grey)
+{
+  unsigned long fill = 0,
+                bits = 0,
+                pixels = 0;
+  unsigned int x = 0;
+
+  memset(&fill, grey, sizeof(fill));
+  for(; width - x >= BLEND_WORD; x += BLEND_WORD)
+  {
+    memcpy(&bits, mask + x, sizeof(bits));
+    memcpy(&pixels, row + x, sizeof(pixels));
+    pixels = (pixels & ~bits) | (fill & bits);
+    memcpy(row + x, &pixels, sizeof(pixels));
+  }
+  for(; x < width; x++)
+  {
+    row[x] = (Grayscale) ((row[x] & ~mask[x]) | (grey & mask[x]));
+  }
 }
 
 
@@ -168,41 +225,27 @@ int checkArgImageInput(char *argv[])
  * @param[in] lineHeigth
  * @param[in] lineSpace
  * @param[in] grey, the grey value
- * 
- * @return return the img
  */
-Image addHLines(Image *img, unsigned int lineHeigth, unsigned int lineSpace, unsigned char grey)
+void addHLines(Image *img, unsigned int lineHeigth, unsigned int lineSpace, unsigned char grey)
 {
+  unsigned long y = 0;
   unsigned int i = 0;
-  unsigned int x = 0;
-  unsigned int y = 0;
-  unsigned int width = imaging_getWidth((*img));
-  unsigned int height = imaging_getHeight((*img));
+  unsigned int width = imaging_getWidth(img);
+  unsigned int height = imaging_getHeight(img);
+  unsigned long period = (unsigned long) lineHeigth + lineSpace;
 
-  for(; y < height; y++)
+  if(period == 0)
   {
-    if(i < lineHeigth)
+    return;
+  }
+
+  for(; y < height; y += period)
+  {
+    for(i = 0; i < lineHeigth && y + i < height; i++)
     {
-      x=0;
-      for(; x < width; x++)
-      {
-        imaging_setGrayscaleAt(img, x, y, grey);
-      }
-      i++;
+      memset(imaging_getRowMutable(img, (unsigned int) (y + i)), grey, width);
     }
-    else
-    {
-      if(lineSpace > 0){
-        y+=(lineSpace-1);
-      }
-      else{
-        y--;
-      }
-      i = 0;
-    }
-    
   }
-  return (*img);
 }
 
 
@@ -210,53 +253,48 @@ Image addHLines(Image *img, unsigned int lineHeigth, unsigned int lineSpace, uns
 /**
  * Add vertival Lines to img
  *
+ * The stripes are the same in every row, so they are computed once as a mask
+ * and blended into each row.
+ *
  * @param[in] img, our image
  * @param[in] lineWidth
  * @param[in] lineSpace
  * @param[in] grey, the grey value
- * 
- * @return return the img
  */
-Image addVLines(Image *img, unsigned int lineWidth, unsigned int lineSpace, unsigned char grey)
+void addVLines(Image *img, unsigned int lineWidth, unsigned int lineSpace, unsigned char grey)
 {
-  unsigned int i = 0;
   unsigned int y = 0;
-  unsigned int x = 0;
-  unsigned int width = imaging_getWidth((*img));
-  unsigned int height = imaging_getHeight((*img));
+  unsigned int width = imaging_getWidth(img);
+  unsigned int height = imaging_getHeight(img);
+  Grayscale * mask = NULL;
 
-  for (; i < height; i++)
+  if(lineWidth == 0 || width == 0)
   {
-    while (y < width)
-    {
-      for (; x < lineWidth; x++)
-      {
-        if (y < width)
-        {
-          imaging_setGrayscaleAt(img, y, i, grey);
-          y++;
-        }
-      }
-
-      x = 0;
-
-      for (; x < lineSpace; x++)
-      {
-        if (y < width)
-        {
-        y++;
-        }
-      }
+    return;
+  }
 
-      x = 0;
+  /** wide stripes are cheaper to set directly */
+  if(lineWidth < 2 * BLEND_WORD)
+  {
+    mask = calloc(width, 1);
+  }
 
+  if(mask != NULL)
+  {
+    fillStripes(mask, width, lineWidth, lineSpace, 0xFF);
+    for(; y < height; y++)
+    {
+      blendRow(imaging_getRowMutable(img, y), mask, width, grey);
+    }
+    free(mask);
+  }
+  else
+  {
+    for(; y < height; y++)
+    {
+      fillStripes(imaging_getRowMutable(img, y), width, lineWidth, lineSpace, grey);
     }
-
-    y=0;
-
   }
-
-  return (*img);
 }
 
 
@@ -268,31 +306,9 @@ Image addVLines(Image *img, unsigned int lineWidth, unsigned int lineSpace, unsi
  * 
  * @return void
  */
-void repeat(Image * img, Image source){
+void repeat(Image * img, const Image * source){
 
-    unsigned int a = 0,
-                 b = 0,
-                 k = 0,
-                 p = 0;
-
-      for(b = 0; b < imaging_getHeight((*img)); b++)
-      {
-        k=0;
-        for(a = 0; a < imaging_getWidth((*img)); a++)
-        {
-          imaging_setGrayscaleAt(img,a,b, imaging_getGrayscaleAt(source,k,p));
-          k++;
-          if(k>=source.width)
-          {
-            k=0;
-          }
-        }
-        p++;
-        if(p>=source.height)
-        {
-          p=0;
-        }
-      }
+  imaging_tile(img, source, 0, 0, imaging_getWidth(source), imaging_getHeight(source), 0, 0);
 }
 
 /**
@@ -310,8 +326,8 @@ int processArguments(int argc, char *argv[])
        z = '\0';
   int i = 0,
       writeChecker = 0;
-  unsigned int ax = 3;
-  unsigned int *ix = &ax;
+  unsigned long ax = 3;
+  unsigned long *ix = &ax;
   FILE * fp;
   Image new = imaging_createEmpty();
   Image new2 = imaging_createEmpty();
@@ -319,10 +335,10 @@ int processArguments(int argc, char *argv[])
   Image *img = &new;
   Errorcode err = ERR_NULL;
 
-  (*img) = imaging_create(convertToInt(argv[1]), convertToInt(argv[2]), convertToInt(argv[3]));
+  err = imaging_create(img, convertToInt(argv[1]), convertToInt(argv[2]), convertToInt(argv[3]));
       
   /** Check the Arguments and Process them **/
-  for (i = 4; i < argc; i += 4)
+  for (i = 4; err == ERR_NULL && i < argc; i += 4)
   {
     x = '\0';
     y = '\0';
@@ -378,6 +394,7 @@ int processArguments(int argc, char *argv[])
         break;
       }
       case 'o':
+      case 'O':
       {
         if(argv[i+1] == NULL)
         {
@@ -388,8 +405,15 @@ int processArguments(int argc, char *argv[])
           fp = fopen(argv[i+1], "wb");
           
           if (fp != NULL) {
-            err = imaging_writePGM((*img), fp, ix);
-            fprintf(stdout,"%d bytes written to file: %s.\n",(*ix),argv[i+1]);
+            if(y == 'O')
+            {
+              err = imaging_writePGMBinary(img, fp, ix);
+            }
+            else
+            {
+              err = imaging_writePGM(img, fp, ix);
+            }
+            fprintf(stdout,"%lu bytes written to file: %s.\n",(*ix),argv[i+1]);
             i -= 2;
             writeChecker = 1;
             fclose(fp);
@@ -413,8 +437,9 @@ int processArguments(int argc, char *argv[])
           {
             err = imaging_readPGM(openImg, fp);
             if(err == ERR_NULL){
-              repeat(img, (*openImg));
+              repeat(img, openImg);
             }
+            imaging_delete(openImg);
             i -= 2;
             fclose(fp);
           } else {
@@ -436,9 +461,11 @@ int processArguments(int argc, char *argv[])
 
   if(writeChecker == 0 && err == ERR_NULL)
   {
-    err = imaging_writePGM((*img), stdout, ix);
+    err = imaging_writePGM(img, stdout, ix);
   }
 
+  imaging_delete(img);
+
   return err;
 }
 
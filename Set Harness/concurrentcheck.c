@@ -0,0 +1,321 @@
+/**
+ * @file concurrentcheck.c Pruefung der nebenlaeufigen Menge (setconcurrent.h)
+ * mit gleichzeitig lesenden und einem schreibenden Thread.
+ *
+ * Der schreibende Thread veraendert die Menge in jeder Runde mit einigen
+ * zufaelligen Einfuege- und Entferne-Operationen und veroeffentlicht das
+ * Ergebnis. Jede Version enthaelt neben den Elementen aus [0, CHECK_UNIVERSE)
+ * genau ein Markierungselement CHECK_MARKER + Runde, ueber das ein Leser die
+ * Runde seiner Version erkennt. Die erste Version (Runde 0) enthaelt nur die
+ * Markierung. Vor der Veroeffentlichung legt der schreibende Thread das Modell
+ * der Runde (ein Flag je Element) ab.
+ *
+ * Die lesenden Threads lesen waehrenddessen ohne Pause Versionen und
+ * vergleichen jede vollstaendig mit dem Modell ihrer Runde. Zusaetzlich muss
+ * die gelesene Runde je Leser monoton steigen. Am Ende wird geprueft, dass
+ * nach dem Abmelden aller Leser keine abgeloeste Version mehr aussteht und
+ * nach dem Freigeben der Menge kein Knoten mehr belegt ist.
+ *
+ * @author alexander loeffler, andre kloodt
+ */
+
+#include "../Dynamic List Set/set.c"
+#include "../Dynamic List Set/setconcurrent.c"
+
+/** Anzahl der moeglichen Elemente einer Version */
+#define CHECK_UNIVERSE 1024
+
+/** erstes Markierungselement, weit oberhalb der Elemente */
+#define CHECK_MARKER (1L << 20)
+
+/** Hoechstzahl der Operationen je Runde */
+#define CHECK_EDITS 8
+
+/** Anzahl der lesenden Threads */
+#define CHECK_READERS 4
+
+/** voreingestellte Anzahl der Runden */
+#define CHECK_DEFAULT_ROUNDS 2000
+
+/**
+ * Gemeinsamer Zustand aller Threads.
+ */
+typedef struct {
+    /** die nebenlaeufige Menge */
+    SetConcurrent set;
+    /** Modell je Runde (0 bis rounds), CHECK_UNIVERSE Flags je Runde */
+    unsigned char * history;
+    /** Anzahl der Runden des schreibenden Threads */
+    unsigned long rounds;
+    /** 1, sobald der schreibende Thread fertig ist */
+    int done;
+    /** schuetzt done */
+    pthread_mutex_t lock;
+} Check;
+
+/**
+ * Ergebnis eines lesenden Threads.
+ */
+typedef struct {
+    /** gemeinsamer Zustand */
+    Check * check;
+    /** Anzahl der gelesenen Versionen */
+    unsigned long reads;
+    /** Anzahl der verschiedenen gelesenen Runden */
+    unsigned long rounds;
+    /** Anzahl der Abweichungen */
+    unsigned long mismatches;
+} Reader;
+
+
+/**
+ * Liefert eine Zufallszahl aus [0, n).
+ *
+ * @param[in] n obere Grenze.
+ *
+ * @return die Zufallszahl.
+ */
+static unsigned long
+randomBelow (unsigned long n) {
+    unsigned long r = ((unsigned long) rand() << 15) ^ (unsigned long) rand();
+
+    return r % n;
+}
+
+/**
+ * Prueft, ob der schreibende Thread fertig ist.
+ *
+ * @param[in] check gemeinsamer Zustand.
+ *
+ * @return 1, falls er fertig ist, sonst 0.
+ */
+static int
+isDone (Check * check) {
+    int done = 0;
+
+    pthread_mutex_lock(&check->lock);
+    done = check->done;
+    pthread_mutex_unlock(&check->lock);
+    return done;
+}
+
+/**
+ * Vergleicht eine Version mit dem Modell ihrer Runde.
+ *
+ * @param[in]  check gemeinsamer Zustand.
+ * @param[in]  s     die Version.
+ * @param[out] round die Runde der Version.
+ *
+ * @return 1, falls die Version abweicht, sonst 0.
+ */
+static int
+differs (const Check * check, Set s, unsigned long * round) {
+    SetListCursor cursor;
+    SetSource src;
+    const unsigned char * member = NULL;
+    Element start = 0, end = 0, e = 0, next = 0;
+    Element marker = 0;
+
+    if (s == EMPTY_SET) {
+        return 1;
+    }
+    marker = set_max(s);
+    if (marker < CHECK_MARKER || (unsigned long) (marker - CHECK_MARKER) > check->rounds) {
+        return 1;
+    }
+    *round = (unsigned long) (marker - CHECK_MARKER);
+    member = check->history + *round * CHECK_UNIVERSE;
+
+    /* jedes Element der Version muss im Modell stehen, jede Luecke davor nicht */
+    src = set_source_list(&cursor, s);
+    while(src.next(src.state, &start, &end)){
+        if (start == marker) {
+            break;
+        }
+        if (start < next || end >= CHECK_UNIVERSE) {
+            return 1;
+        }
+        for(e = next; e < start; e++){
+            if (member[e]) {
+                return 1;
+            }
+        }
+        for(e = start; e <= end; e++){
+            if (!member[e]) {
+                return 1;
+            }
+        }
+        next = end + 1;
+    }
+    if (start != marker || end != marker) {
+        return 1;
+    }
+    for(e = next; e < CHECK_UNIVERSE; e++){
+        if (member[e]) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Lesender Thread: liest Versionen, bis der schreibende Thread fertig ist.
+ *
+ * @param[in,out] arg der Leser (Reader).
+ *
+ * @return NULL.
+ */
+static void *
+readLoop (void * arg) {
+    Reader * r = arg;
+    Check * check = r->check;
+    unsigned long round = 0, last = 0;
+    int slot = setconcurrent_register(&check->set);
+    int finished = 0;
+
+    if (slot < 0) {
+        r->mismatches++;
+        return NULL;
+    }
+    do {
+        /* erst nach dem Ende des Schreibers ein letztes Mal lesen, damit
+         * auch die letzte Version geprueft wird */
+        finished = isDone(check);
+        if (differs(check, setconcurrent_read_begin(&check->set, slot), &round)) {
+            r->mismatches++;
+        } else if (round < last) {
+            r->mismatches++;
+        } else if (round > last || r->reads == 0) {
+            r->rounds++;
+            last = round;
+        }
+        setconcurrent_read_end(&check->set, slot);
+        r->reads++;
+    } while(!finished);
+    if (last != check->rounds) {
+        r->mismatches++;
+    }
+    setconcurrent_unregister(&check->set, slot);
+    return NULL;
+}
+
+/**
+ * Schreibender Thread (der aufrufende): fuehrt alle Runden aus.
+ *
+ * @param[in,out] check gemeinsamer Zustand.
+ */
+static void
+writeLoop (Check * check) {
+    unsigned char * member = NULL;
+    unsigned long round = 0, edits = 0, i = 0;
+    Element e = 0;
+    Set s = EMPTY_SET;
+
+    for(round = 1; round <= check->rounds; round++){
+        member = check->history + round * CHECK_UNIVERSE;
+        memcpy(member, member - CHECK_UNIVERSE, CHECK_UNIVERSE);
+
+        s = setconcurrent_edit_begin(&check->set);
+        s = set_remove(s, CHECK_MARKER + (Element) round - 1);
+        for(edits = 1 + randomBelow(CHECK_EDITS), i = 0; i < edits; i++){
+            e = (Element) randomBelow(CHECK_UNIVERSE);
+            if (randomBelow(2) == 0) {
+                s = set_insert(s, e);
+                member[e] = 1;
+            } else {
+                s = set_remove(s, e);
+                member[e] = 0;
+            }
+        }
+        s = set_insert(s, CHECK_MARKER + (Element) round);
+        setconcurrent_edit_commit(&check->set, s);
+    }
+
+    pthread_mutex_lock(&check->lock);
+    check->done = 1;
+    pthread_mutex_unlock(&check->lock);
+}
+
+/**
+ * Hauptprogramm.
+ *
+ * Optional koennen der Startwert des Zufallsgenerators und die Anzahl der
+ * Runden angegeben werden.
+ *
+ * @param[in] argc Anzahl der Kommandozeilenargumente.
+ * @param[in] argv Array mit Kommandozeilenargumenten.
+ *
+ * @return EXIT_SUCCESS, falls alle gelesenen Versionen dem Modell entsprechen.
+ */
+int
+main (int argc, char * argv[]) {
+    Check check;
+    Reader readers[CHECK_READERS];
+    pthread_t ids[CHECK_READERS];
+    int started[CHECK_READERS];
+    unsigned long seed = 1, mismatches = 0, retired = 0;
+    SetRetired * r = NULL;
+    SetStats stats;
+    int i = 0;
+
+    check.rounds = CHECK_DEFAULT_ROUNDS;
+    if (argc > 3 || (argc > 1 && sscanf(argv[1], "%lu", &seed) != 1)
+            || (argc > 2 && (sscanf(argv[2], "%lu", &check.rounds) != 1 || check.rounds == 0))) {
+        fprintf(stderr, "Usage: concurrentcheck [SEED [ROUNDS]]\n");
+        return EXIT_FAILURE;
+    }
+    srand((unsigned int) seed);
+
+    check.history = malloc((check.rounds + 1) * CHECK_UNIVERSE);
+    if (check.history == NULL) {
+        exit(ERR_OUT_OF_MEMORY);
+    }
+    memset(check.history, 0, CHECK_UNIVERSE);
+    check.done = 0;
+    pthread_mutex_init(&check.lock, NULL);
+    set_stats_reset();
+    setconcurrent_init(&check.set, set_insert(EMPTY_SET, CHECK_MARKER));
+
+    for(i = 0; i < CHECK_READERS; i++){
+        readers[i].check = &check;
+        readers[i].reads = 0;
+        readers[i].rounds = 0;
+        readers[i].mismatches = 0;
+        started[i] = pthread_create(&ids[i], NULL, readLoop, &readers[i]) == 0;
+    }
+    writeLoop(&check);
+
+    printf("reader,reads,rounds_seen,mismatches\n");
+    for(i = 0; i < CHECK_READERS; i++){
+        if (!started[i]) {
+            fprintf(stderr, "reader %d could not be started\n", i);
+            mismatches++;
+            continue;
+        }
+        pthread_join(ids[i], NULL);
+        printf("%d,%lu,%lu,%lu\n", i, readers[i].reads, readers[i].rounds, readers[i].mismatches);
+        mismatches += readers[i].mismatches;
+    }
+
+    /* ohne Leser muss die naechste Veroeffentlichung alles Abgeloeste freigeben */
+    setconcurrent_remove(&check.set, CHECK_MARKER + (Element) check.rounds);
+    for(r = check.set.retired; r != NULL; r = r->next){
+        retired++;
+    }
+    if (retired != 0) {
+        fprintf(stderr, "%lu retired versions left without readers\n", retired);
+        mismatches++;
+    }
+
+    setconcurrent_destroy(&check.set);
+    set_stats_get(&stats);
+    if (stats.liveNodes != 0) {
+        fprintf(stderr, "%lu nodes left after destroy\n", stats.liveNodes);
+        mismatches++;
+    }
+
+    pthread_mutex_destroy(&check.lock);
+    free(check.history);
+
+    return mismatches == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,83 @@
+#ifndef __ENGINE_H__
+#define __ENGINE_H__
+
+/**
+ * @file engine.h Gemeinsame Schnittstelle der Mengen-Bibliotheken fuer den
+ * Vergleich im Harness.
+ *
+ * Jede Bibliothek wird in einer eigenen Uebersetzungseinheit eingebunden und
+ * hinter dieser Schnittstelle versteckt, so dass sich die gleichnamigen
+ * Funktionen (set_insert, ...) nicht in die Quere kommen. Mengen werden als
+ * undurchsichtige Zeiger uebergeben.
+ *
+ * @author alexander loeffler, andre kloodt
+ */
+
+/** groesstes Element aller Lasten, muss von jeder Bibliothek darstellbar sein */
+#ifndef HARNESS_MAX_ELEM
+#define HARNESS_MAX_ELEM 65535
+#endif
+
+/**
+ * Verknuepfungen zweier Mengen.
+ */
+typedef enum {
+  ENGINE_UNION,
+  ENGINE_INTERSECTION,
+  ENGINE_DIFFERENCE,
+  ENGINE_SYMMETRIC_DIFFERENCE
+} EngineOp;
+
+/**
+ * Eine Mengen-Bibliothek.
+ */
+typedef struct {
+  /** Name der Bibliothek in der Ausgabe */
+  const char * name;
+  /** Erzeugt eine leere Menge. */
+  void * (*create) (void);
+  /** Gibt eine Menge frei. */
+  void (*destroy) (void * s);
+  /** Fuegt ein Element ein. */
+  void (*insert) (void * s, unsigned long e);
+  /** Entfernt ein Element. */
+  void (*remove) (void * s, unsigned long e);
+  /** Prueft, ob ein Element enthalten ist. */
+  int (*contains) (void * s, unsigned long e);
+  /** Liefert die Anzahl der Elemente. */
+  unsigned long (*cardinality) (void * s);
+  /** Liefert das kleinste Element einer nicht leeren Menge. */
+  unsigned long (*min) (void * s);
+  /** Liefert das groesste Element einer nicht leeren Menge. */
+  unsigned long (*max) (void * s);
+  /** Prueft, ob a Teilmenge von b ist. */
+  int (*is_subset) (void * a, void * b);
+  /** Prueft, ob a und b gleich sind. */
+  int (*equals) (void * a, void * b);
+  /** Erzeugt die Verknuepfung von a und b als neue Menge. */
+  void * (*combine) (void * a, void * b, EngineOp op);
+  /**
+   * Schreibt die Elemente aufsteigend sortiert nach out (hoechstens max viele)
+   * und liefert ihre Anzahl.
+   */
+  unsigned long (*elements) (void * s, unsigned long * out, unsigned long max);
+  /** Liefert den Speicherbedarf einer Menge in Bytes. */
+  unsigned long (*bytes) (void * s);
+} Engine;
+
+/** die Bit-Menge (Bit Set) */
+extern const Engine engine_bitset;
+
+/** die Intervall-Liste (Dynamic List Set) */
+extern const Engine engine_listset;
+
+/** die Intervall-Liste mit paralleler Verknuepfung (setparallel.h) */
+extern const Engine engine_listset_parallel;
+
+/** die Intervall-Liste mit Verknuepfung ueber einen Index (setindex.h) */
+extern const Engine engine_listset_index;
+
+/** die Intervall-Liste mit Verknuepfung mehrerer Mengen (set_combine_all) */
+extern const Engine engine_listset_nary;
+
+#endif
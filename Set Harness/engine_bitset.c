@@ -0,0 +1,246 @@
+/**
+ * @file engine_bitset.c Anbindung der Bit-Menge (Bit Set) an den Harness.
+ *
+ * Die Bibliothek wird direkt eingebunden, ihre Funktionen und Typen werden
+ * dazu umbenannt.
+ *
+ * @author alexander loeffler, andre kloodt
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "engine.h"
+
+#define SET_MAX_ELEM HARNESS_MAX_ELEM
+
+#define Set BitSet
+#define Element BitElement
+#define set_insert bitset_insert
+#define set_remove bitset_remove
+#define set_remove_all_elems bitset_remove_all_elems
+#define set_is_empty bitset_is_empty
+#define set_cardinality bitset_cardinality
+#define set_max bitset_max
+#define set_min bitset_min
+#define set_contains bitset_contains
+#define set_is_subset bitset_is_subset
+#define set_equals bitset_equals
+#define set_union bitset_union
+#define set_intersection bitset_intersection
+#define set_difference bitset_difference
+#define set_symmetric_difference bitset_symmetric_difference
+#define set_copy bitset_copy
+#define set_partition bitset_partition
+#define set_print bitset_print
+
+#include "../Bit Set/set.c"
+
+
+/**
+ * Erzeugt eine leere Bit-Menge.
+ *
+ * @return die Menge.
+ */
+static void *
+bitCreate (void) {
+    void * s = calloc(1, sizeof(BitSet));
+
+    if (s == NULL) {
+        exit(EXIT_FAILURE);
+    }
+    return s;
+}
+
+/**
+ * Gibt eine Bit-Menge frei.
+ *
+ * @param[in] s die Menge.
+ */
+static void
+bitDestroy (void * s) {
+    free(s);
+}
+
+/**
+ * Fuegt ein Element in eine Bit-Menge ein.
+ *
+ * @param[in,out] s die Menge.
+ * @param[in]     e das Element.
+ */
+static void
+bitInsert (void * s, unsigned long e) {
+    bitset_insert(s, e);
+}
+
+/**
+ * Entfernt ein Element aus einer Bit-Menge.
+ *
+ * @param[in,out] s die Menge.
+ * @param[in]     e das Element.
+ */
+static void
+bitRemove (void * s, unsigned long e) {
+    bitset_remove(s, e);
+}
+
+/**
+ * Prueft, ob ein Element in einer Bit-Menge enthalten ist.
+ *
+ * @param[in] s die Menge.
+ * @param[in] e das Element.
+ *
+ * @return 1, falls das Element enthalten ist, sonst 0.
+ */
+static int
+bitContains (void * s, unsigned long e) {
+    return bitset_contains(*(BitSet *) s, e) != 0;
+}
+
+/**
+ * Liefert die Anzahl der Elemente einer Bit-Menge.
+ *
+ * @param[in] s die Menge.
+ *
+ * @return die Kardinalitaet.
+ */
+static unsigned long
+bitCardinality (void * s) {
+    return bitset_cardinality(*(BitSet *) s);
+}
+
+/**
+ * Liefert das kleinste Element einer Bit-Menge.
+ *
+ * @param[in] s die Menge.
+ *
+ * @return das Minimum.
+ */
+static unsigned long
+bitMin (void * s) {
+    return bitset_min(*(BitSet *) s);
+}
+
+/**
+ * Liefert das groesste Element einer Bit-Menge.
+ *
+ * @param[in] s die Menge.
+ *
+ * @return das Maximum.
+ */
+static unsigned long
+bitMax (void * s) {
+    return bitset_max(*(BitSet *) s);
+}
+
+/**
+ * Prueft, ob a Teilmenge von b ist.
+ *
+ * @param[in] a die erste Menge.
+ * @param[in] b die zweite Menge.
+ *
+ * @return 1, falls a Teilmenge von b ist, sonst 0.
+ */
+static int
+bitIsSubset (void * a, void * b) {
+    return bitset_is_subset(*(BitSet *) a, *(BitSet *) b) != 0;
+}
+
+/**
+ * Prueft, ob a und b gleich sind.
+ *
+ * @param[in] a die erste Menge.
+ * @param[in] b die zweite Menge.
+ *
+ * @return 1, falls die Mengen gleich sind, sonst 0.
+ */
+static int
+bitEquals (void * a, void * b) {
+    return bitset_equals(*(BitSet *) a, *(BitSet *) b) != 0;
+}
+
+/**
+ * Erzeugt die Verknuepfung zweier Bit-Mengen.
+ *
+ * @param[in] a  die erste Menge.
+ * @param[in] b  die zweite Menge.
+ * @param[in] op die Verknuepfung.
+ *
+ * @return die neue Menge.
+ */
+static void *
+bitCombine (void * a, void * b, EngineOp op) {
+    BitSet * res = bitCreate();
+
+    switch (op) {
+        case ENGINE_UNION:
+            bitset_union(res, *(BitSet *) a, *(BitSet *) b);
+            break;
+        case ENGINE_INTERSECTION:
+            bitset_intersection(res, *(BitSet *) a, *(BitSet *) b);
+            break;
+        case ENGINE_DIFFERENCE:
+            bitset_difference(res, *(BitSet *) a, *(BitSet *) b);
+            break;
+        case ENGINE_SYMMETRIC_DIFFERENCE:
+            bitset_symmetric_difference(res, *(BitSet *) a, *(BitSet *) b);
+            break;
+    }
+    return res;
+}
+
+/**
+ * Schreibt die Elemente einer Bit-Menge aufsteigend sortiert in ein Feld.
+ *
+ * @param[in]  s   die Menge.
+ * @param[out] out das Feld.
+ * @param[in]  max Groesse des Felds.
+ *
+ * @return Anzahl der Elemente.
+ */
+static unsigned long
+bitElements (void * s, unsigned long * out, unsigned long max) {
+    unsigned long e = 0;
+    unsigned long count = 0;
+
+    for(e = 0; e <= HARNESS_MAX_ELEM; e++){
+        if (bitset_contains(*(BitSet *) s, e)) {
+            if (count < max) {
+                out[count] = e;
+            }
+            count++;
+        }
+    }
+    return count;
+}
+
+/**
+ * Liefert den Speicherbedarf einer Bit-Menge.
+ *
+ * @param[in] s die Menge.
+ *
+ * @return Groesse in Bytes.
+ */
+static unsigned long
+bitBytes (void * s) {
+    (void) s;
+    return sizeof(BitSet);
+}
+
+
+const Engine engine_bitset = {
+    "bitset",
+    bitCreate,
+    bitDestroy,
+    bitInsert,
+    bitRemove,
+    bitContains,
+    bitCardinality,
+    bitMin,
+    bitMax,
+    bitIsSubset,
+    bitEquals,
+    bitCombine,
+    bitElements,
+    bitBytes
+};
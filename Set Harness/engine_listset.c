@@ -0,0 +1,400 @@
+/**
+ * @file engine_listset.c Anbindung der Intervall-Liste (Dynamic List Set) an
+ * den Harness.
+ *
+ * Die Bibliothek wird direkt eingebunden, damit der Speicherbedarf einer Menge
+ * aus den internen Knotengroessen bestimmt werden kann.
+ *
+ * Neben set_combine werden die weiteren Verknuepfungen der Bibliothek als
+ * eigene Engines angebunden, die sich nur in combine unterscheiden: die
+ * parallele Verknuepfung (setparallel.h), Schnitt und Differenz mit einem Index
+ * (setindex.h) und die Verknuepfung mehrerer Mengen (set_combine_all).
+ *
+ * @author alexander loeffler, andre kloodt
+ */
+
+#include "engine.h"
+
+#include "../Dynamic List Set/set.c"
+#include "../Dynamic List Set/setindex.c"
+#include "../Dynamic List Set/setparallel.h"
+
+/** Anzahl der Threads der parallelen Verknuepfung */
+#define LIST_PARALLEL_THREADS 4
+
+/**
+ * Eine Menge der Intervall-Liste. Die Liste selbst aendert beim Einfuegen und
+ * Entfernen ihren Anfang, daher wird sie in einem Handle gehalten.
+ */
+typedef struct {
+    Set set;
+} ListHandle;
+
+
+/**
+ * Erzeugt eine leere Menge.
+ *
+ * @return die Menge.
+ */
+static void *
+listCreate (void) {
+    ListHandle * h = malloc(sizeof(ListHandle));
+
+    if (h == NULL) {
+        exit(ERR_OUT_OF_MEMORY);
+    }
+    h->set = EMPTY_SET;
+    return h;
+}
+
+/**
+ * Gibt eine Menge frei.
+ *
+ * @param[in] s die Menge.
+ */
+static void
+listDestroy (void * s) {
+    ListHandle * h = s;
+
+    h->set = set_clear(h->set);
+    free(h);
+}
+
+/**
+ * Fuegt ein Element ein.
+ *
+ * @param[in,out] s die Menge.
+ * @param[in]     e das Element.
+ */
+static void
+listInsert (void * s, unsigned long e) {
+    ListHandle * h = s;
+
+    h->set = set_insert(h->set, (Element) e);
+}
+
+/**
+ * Entfernt ein Element.
+ *
+ * @param[in,out] s die Menge.
+ * @param[in]     e das Element.
+ */
+static void
+listRemove (void * s, unsigned long e) {
+    ListHandle * h = s;
+
+    h->set = set_remove(h->set, (Element) e);
+}
+
+/**
+ * Prueft, ob ein Element enthalten ist.
+ *
+ * @param[in] s die Menge.
+ * @param[in] e das Element.
+ *
+ * @return 1, falls das Element enthalten ist, sonst 0.
+ */
+static int
+listContains (void * s, unsigned long e) {
+    return set_contains(((ListHandle *) s)->set, (Element) e);
+}
+
+/**
+ * Liefert die Anzahl der Elemente.
+ *
+ * @param[in] s die Menge.
+ *
+ * @return die Kardinalitaet.
+ */
+static unsigned long
+listCardinality (void * s) {
+    return set_cardinality(((ListHandle *) s)->set);
+}
+
+/**
+ * Liefert das kleinste Element.
+ *
+ * @param[in] s die Menge.
+ *
+ * @return das Minimum.
+ */
+static unsigned long
+listMin (void * s) {
+    return (unsigned long) set_min(((ListHandle *) s)->set);
+}
+
+/**
+ * Liefert das groesste Element.
+ *
+ * @param[in] s die Menge.
+ *
+ * @return das Maximum.
+ */
+static unsigned long
+listMax (void * s) {
+    return (unsigned long) set_max(((ListHandle *) s)->set);
+}
+
+/**
+ * Prueft, ob a Teilmenge von b ist.
+ *
+ * @param[in] a die erste Menge.
+ * @param[in] b die zweite Menge.
+ *
+ * @return 1, falls a Teilmenge von b ist, sonst 0.
+ */
+static int
+listIsSubset (void * a, void * b) {
+    return set_is_subset(((ListHandle *) a)->set, ((ListHandle *) b)->set);
+}
+
+/**
+ * Prueft, ob a und b gleich sind.
+ *
+ * @param[in] a die erste Menge.
+ * @param[in] b die zweite Menge.
+ *
+ * @return 1, falls die Mengen gleich sind, sonst 0.
+ */
+static int
+listEquals (void * a, void * b) {
+    return set_equals(((ListHandle *) a)->set, ((ListHandle *) b)->set);
+}
+
+/**
+ * Liefert die Verknuepfung der Bibliothek zu einer Verknuepfung des Harness.
+ *
+ * @param[in] op die Verknuepfung.
+ *
+ * @return die Verknuepfung der Bibliothek.
+ */
+static SetOp
+listOp (EngineOp op) {
+    switch (op) {
+        case ENGINE_INTERSECTION:
+            return SET_OP_INTERSECTION;
+        case ENGINE_DIFFERENCE:
+            return SET_OP_DIFFERENCE;
+        case ENGINE_SYMMETRIC_DIFFERENCE:
+            return SET_OP_SYMMETRIC_DIFFERENCE;
+        default:
+            return SET_OP_UNION;
+    }
+}
+
+/**
+ * Erzeugt die Verknuepfung zweier Mengen.
+ *
+ * @param[in] a  die erste Menge.
+ * @param[in] b  die zweite Menge.
+ * @param[in] op die Verknuepfung.
+ *
+ * @return die neue Menge.
+ */
+static void *
+listCombine (void * a, void * b, EngineOp op) {
+    ListHandle * res = listCreate();
+
+    res->set = set_combine(((ListHandle *) a)->set, ((ListHandle *) b)->set, listOp(op));
+    return res;
+}
+
+/**
+ * Erzeugt die Verknuepfung zweier Mengen mit setparallel_combine.
+ *
+ * @param[in] a  die erste Menge.
+ * @param[in] b  die zweite Menge.
+ * @param[in] op die Verknuepfung.
+ *
+ * @return die neue Menge.
+ */
+static void *
+listCombineParallel (void * a, void * b, EngineOp op) {
+    ListHandle * res = listCreate();
+
+    res->set = setparallel_combine(((ListHandle *) a)->set, ((ListHandle *) b)->set,
+                                   listOp(op), LIST_PARALLEL_THREADS);
+    return res;
+}
+
+/**
+ * Erzeugt die Verknuepfung zweier Mengen ueber einen Index von b: Schnitt und
+ * Differenz mit setindex_intersection bzw. setindex_difference, die uebrigen
+ * Verknuepfungen mit set_merge aus der Liste a und der Index-Quelle von b.
+ * Die Zeit fuer den Aufbau des Index wird mitgemessen.
+ *
+ * @param[in] a  die erste Menge.
+ * @param[in] b  die zweite Menge.
+ * @param[in] op die Verknuepfung.
+ *
+ * @return die neue Menge.
+ */
+static void *
+listCombineIndex (void * a, void * b, EngineOp op) {
+    ListHandle * res = listCreate();
+    SetIndex idx = setindex_create(((ListHandle *) b)->set);
+    SetListCursor ca;
+    SetIndexCursor cb;
+    SetSource srcA, srcB;
+
+    switch (op) {
+        case ENGINE_INTERSECTION:
+            res->set = setindex_intersection(((ListHandle *) a)->set, &idx);
+            break;
+        case ENGINE_DIFFERENCE:
+            res->set = setindex_difference(((ListHandle *) a)->set, &idx);
+            break;
+        default:
+            srcA = set_source_list(&ca, ((ListHandle *) a)->set);
+            srcB = setindex_source(&cb, &idx);
+            res->set = set_merge_build(&srcA, &srcB, listOp(op));
+    }
+    setindex_delete(&idx);
+    return res;
+}
+
+/**
+ * Erzeugt die Verknuepfung zweier Mengen ueber die Verknuepfung mehrerer
+ * Mengen: Vereinigung und Schnitt mit set_combine_all, die Differenz als
+ * umgekehrte Differenz der vertauschten Mengen und die symmetrische Differenz
+ * mit vertauschten Mengen.
+ *
+ * @param[in] a  die erste Menge.
+ * @param[in] b  die zweite Menge.
+ * @param[in] op die Verknuepfung.
+ *
+ * @return die neue Menge.
+ */
+static void *
+listCombineNary (void * a, void * b, EngineOp op) {
+    ListHandle * res = listCreate();
+    Set sets[2];
+
+    sets[0] = ((ListHandle *) a)->set;
+    sets[1] = ((ListHandle *) b)->set;
+    switch (op) {
+        case ENGINE_DIFFERENCE:
+            res->set = set_combine(sets[1], sets[0], SET_OP_REVERSE_DIFFERENCE);
+            break;
+        case ENGINE_SYMMETRIC_DIFFERENCE:
+            res->set = set_combine(sets[1], sets[0], SET_OP_SYMMETRIC_DIFFERENCE);
+            break;
+        default:
+            res->set = set_combine_all(sets, 2, listOp(op));
+    }
+    return res;
+}
+
+/**
+ * Schreibt die Elemente aufsteigend sortiert in ein Feld.
+ *
+ * @param[in]  s   die Menge.
+ * @param[out] out das Feld.
+ * @param[in]  max Groesse des Felds.
+ *
+ * @return Anzahl der Elemente.
+ */
+static unsigned long
+listElements (void * s, unsigned long * out, unsigned long max) {
+    SetListCursor cursor;
+    SetSource src = set_source_list(&cursor, ((ListHandle *) s)->set);
+    Element start = 0, end = 0, e = 0;
+    unsigned long count = 0;
+
+    while(src.next(src.state, &start, &end)){
+        for(e = start; ; e++){
+            if (count < max) {
+                out[count] = (unsigned long) e;
+            }
+            count++;
+            if (e == end) {
+                break;
+            }
+        }
+    }
+    return count;
+}
+
+/**
+ * Liefert den Speicherbedarf aller Knoten einer Menge.
+ *
+ * @param[in] s die Menge.
+ *
+ * @return Groesse in Bytes.
+ */
+static unsigned long
+listBytes (void * s) {
+    SetShape shape;
+
+    set_stats_shape(((ListHandle *) s)->set, &shape);
+    return shape.nodes * sizeof(struct Intervall) + shape.bitmapNodes * CHUNK_BYTES;
+}
+
+
+const Engine engine_listset = {
+    "listset",
+    listCreate,
+    listDestroy,
+    listInsert,
+    listRemove,
+    listContains,
+    listCardinality,
+    listMin,
+    listMax,
+    listIsSubset,
+    listEquals,
+    listCombine,
+    listElements,
+    listBytes
+};
+
+const Engine engine_listset_parallel = {
+    "listset_parallel",
+    listCreate,
+    listDestroy,
+    listInsert,
+    listRemove,
+    listContains,
+    listCardinality,
+    listMin,
+    listMax,
+    listIsSubset,
+    listEquals,
+    listCombineParallel,
+    listElements,
+    listBytes
+};
+
+const Engine engine_listset_index = {
+    "listset_index",
+    listCreate,
+    listDestroy,
+    listInsert,
+    listRemove,
+    listContains,
+    listCardinality,
+    listMin,
+    listMax,
+    listIsSubset,
+    listEquals,
+    listCombineIndex,
+    listElements,
+    listBytes
+};
+
+const Engine engine_listset_nary = {
+    "listset_nary",
+    listCreate,
+    listDestroy,
+    listInsert,
+    listRemove,
+    listContains,
+    listCardinality,
+    listMin,
+    listMax,
+    listIsSubset,
+    listEquals,
+    listCombineNary,
+    listElements,
+    listBytes
+};
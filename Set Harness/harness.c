@@ -0,0 +1,585 @@
+/**
+ * @file harness.c Vergleich der Mengen-Bibliotheken auf gemeinsamen Lasten.
+ *
+ * Fuer jede Last werden zwei Mengen erzeugt und jede Operation mit jeder
+ * Bibliothek (siehe engine.h) ausgefuehrt. Die Ergebnisse werden mit einem
+ * einfachen Modell (ein Flag je Element) verglichen, Abweichungen auf stderr
+ * gemeldet und gezaehlt. Zusaetzlich wird die Laufzeit je Operation und der
+ * Speicherbedarf einer Menge gemessen. Die Ergebnisse werden als CSV-Tabelle
+ * auf stdout ausgegeben.
+ *
+ * @author alexander loeffler, andre kloodt
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "engine.h"
+
+/** Anzahl der moeglichen Elemente */
+#define UNIVERSE (HARNESS_MAX_ELEM + 1UL)
+
+/** Anzahl der Anfragen je Messung von contains */
+#define HARNESS_QUERIES 4096
+
+/** voreingestellte Mindestdauer einer Messung in Millisekunden */
+#define HARNESS_DEFAULT_MS 20
+
+/** alle verglichenen Bibliotheken, die erste dient als Referenz der Ausgabe */
+static const Engine * engines[] = {
+    &engine_listset,
+    &engine_listset_parallel,
+    &engine_listset_index,
+    &engine_listset_nary,
+    &engine_bitset
+};
+
+/** Anzahl der Bibliotheken */
+#define ENGINE_COUNT (sizeof(engines) / sizeof(engines[0]))
+
+/** Mindestdauer einer Messung in Takten von clock */
+static clock_t minClocks = 0;
+
+/** Gesamtzahl der Abweichungen */
+static unsigned long totalMismatches = 0;
+
+/**
+ * Eine Last, die eine Menge als Flags je Element erzeugt.
+ */
+typedef struct {
+    /** Name in der Ausgabe */
+    const char * name;
+    /** Setzt die Flags der enthaltenen Elemente (das Feld ist geleert). */
+    void (*generate) (unsigned char * member);
+} Workload;
+
+/**
+ * Eine Messung: verbrauchte Takte und Anzahl der Operationen.
+ */
+typedef struct {
+    clock_t clocks;
+    unsigned long ops;
+} Timing;
+
+/**
+ * Zustand einer Last waehrend der Messung einer Bibliothek.
+ */
+typedef struct {
+    /** Name der Last */
+    const char * workload;
+    /** die Bibliothek */
+    const Engine * engine;
+    /** Modell der beiden Mengen */
+    const unsigned char * memberA;
+    const unsigned char * memberB;
+    /** Elemente der beiden Mengen in Einfuegereihenfolge */
+    const unsigned long * elemsA;
+    unsigned long countA;
+    const unsigned long * elemsB;
+    unsigned long countB;
+    /** Anfragen fuer contains */
+    const unsigned long * queries;
+    /** Puffer fuer die Elemente eines Ergebnisses */
+    unsigned long * buffer;
+    /** Speicherbedarf der ersten Menge */
+    unsigned long bytes;
+} Run;
+
+
+/**
+ * Liefert eine Zufallszahl aus [0, n).
+ *
+ * @param[in] n obere Grenze.
+ *
+ * @return die Zufallszahl.
+ */
+static unsigned long
+randomBelow (unsigned long n) {
+    unsigned long r = ((unsigned long) rand() << 15) ^ (unsigned long) rand();
+
+    return r % n;
+}
+
+/**
+ * Last: jedes Element mit Wahrscheinlichkeit 1/8.
+ *
+ * @param[out] member die Flags.
+ */
+static void
+generateRandom (unsigned char * member) {
+    unsigned long e = 0;
+
+    for(e = 0; e < UNIVERSE; e++){
+        member[e] = randomBelow(8) == 0;
+    }
+}
+
+/**
+ * Last: Bloecke von 1 bis 256 Elementen mit Luecken von 1 bis 512.
+ *
+ * @param[out] member die Flags.
+ */
+static void
+generateClustered (unsigned char * member) {
+    unsigned long e = randomBelow(512);
+    unsigned long length = 0;
+
+    while(e < UNIVERSE){
+        for(length = 1 + randomBelow(256); length > 0 && e < UNIVERSE; length--){
+            member[e++] = 1;
+        }
+        e += 1 + randomBelow(512);
+    }
+}
+
+/**
+ * Last: jedes Element mit Wahrscheinlichkeit 15/16.
+ *
+ * @param[out] member die Flags.
+ */
+static void
+generateDense (unsigned char * member) {
+    unsigned long e = 0;
+
+    for(e = 0; e < UNIVERSE; e++){
+        member[e] = randomBelow(16) != 0;
+    }
+}
+
+/**
+ * Last: jedes zweite Element ab einem zufaelligen Anfang (ungueenstigster Fall
+ * fuer Intervalle).
+ *
+ * @param[out] member die Flags.
+ */
+static void
+generateAlternating (unsigned char * member) {
+    unsigned long e = 0;
+
+    for(e = randomBelow(2); e < UNIVERSE; e += 2){
+        member[e] = 1;
+    }
+}
+
+/**
+ * Last: 16 zufaellige Elemente.
+ *
+ * @param[out] member die Flags.
+ */
+static void
+generateSparse (unsigned char * member) {
+    int i = 0;
+
+    for(i = 0; i < 16; i++){
+        member[randomBelow(UNIVERSE)] = 1;
+    }
+}
+
+/**
+ * Last: die Raender des Wertebereichs sowie zufaellige Elemente um jede
+ * 4096. Position (Block- und Wortgrenzen).
+ *
+ * @param[out] member die Flags.
+ */
+static void
+generateBoundaries (unsigned char * member) {
+    unsigned long e = 0;
+
+    member[0] = 1;
+    member[1] = 1;
+    member[UNIVERSE - 2] = 1;
+    member[UNIVERSE - 1] = 1;
+    for(e = 4096; e < UNIVERSE; e += 4096){
+        member[e - 1] = (unsigned char) randomBelow(2);
+        member[e] = (unsigned char) randomBelow(2);
+        member[e + 1 < UNIVERSE ? e + 1 : e] = (unsigned char) randomBelow(2);
+    }
+}
+
+/** alle Lasten */
+static const Workload workloads[] = {
+    { "random", generateRandom },
+    { "clustered", generateClustered },
+    { "dense", generateDense },
+    { "alternating", generateAlternating },
+    { "sparse", generateSparse },
+    { "boundaries", generateBoundaries }
+};
+
+/** Anzahl der Lasten */
+#define WORKLOAD_COUNT (sizeof(workloads) / sizeof(workloads[0]))
+
+
+/**
+ * Legt Speicher an und beendet das Programm, falls keiner verfuegbar ist.
+ *
+ * @param[in] bytes Groesse in Bytes.
+ *
+ * @return der Speicher.
+ */
+static void *
+allocate (size_t bytes) {
+    void * p = malloc(bytes);
+
+    if (p == NULL) {
+        fprintf(stderr, "out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+    return p;
+}
+
+/**
+ * Sammelt die Elemente eines Modells und mischt sie.
+ *
+ * @param[in]  member die Flags.
+ * @param[out] elems  die Elemente.
+ *
+ * @return Anzahl der Elemente.
+ */
+static unsigned long
+collect (const unsigned char * member, unsigned long * elems) {
+    unsigned long e = 0, count = 0, i = 0, j = 0, tmp = 0;
+
+    for(e = 0; e < UNIVERSE; e++){
+        if (member[e]) {
+            elems[count++] = e;
+        }
+    }
+    for(i = count; i > 1; i--){
+        j = randomBelow(i);
+        tmp = elems[i - 1];
+        elems[i - 1] = elems[j];
+        elems[j] = tmp;
+    }
+    return count;
+}
+
+/**
+ * Erzeugt eine Menge aus einer Liste von Elementen.
+ *
+ * @param[in] engine die Bibliothek.
+ * @param[in] elems  die Elemente.
+ * @param[in] count  Anzahl der Elemente.
+ *
+ * @return die Menge.
+ */
+static void *
+build (const Engine * engine, const unsigned long * elems, unsigned long count) {
+    void * s = engine->create();
+    unsigned long i = 0;
+
+    for(i = 0; i < count; i++){
+        engine->insert(s, elems[i]);
+    }
+    return s;
+}
+
+/**
+ * Meldet eine Abweichung vom Modell.
+ *
+ * @param[in] run  die Messung.
+ * @param[in] op   die Operation.
+ * @param[in] what Beschreibung der Abweichung.
+ *
+ * @return 1.
+ */
+static unsigned long
+mismatch (const Run * run, const char * op, const char * what) {
+    fprintf(stderr, "mismatch: workload=%s engine=%s op=%s: %s\n",
+            run->workload, run->engine->name, op, what);
+    return 1;
+}
+
+/**
+ * Vergleicht den Inhalt einer Menge mit dem Modell a OP b.
+ *
+ * @param[in] run die Messung.
+ * @param[in] s   die Menge.
+ * @param[in] op  die Verknuepfung (ENGINE_*), -1 fuer a selbst.
+ *
+ * @return 1, falls der Inhalt abweicht, sonst 0.
+ */
+static int
+differs (const Run * run, void * s, int op) {
+    unsigned long count = run->engine->elements(s, run->buffer, UNIVERSE);
+    unsigned long e = 0, i = 0;
+    int expected = 0;
+
+    if (count > UNIVERSE) {
+        return 1;
+    }
+    for(e = 0; e < UNIVERSE; e++){
+        switch (op) {
+            case ENGINE_UNION:
+                expected = run->memberA[e] || run->memberB[e];
+                break;
+            case ENGINE_INTERSECTION:
+                expected = run->memberA[e] && run->memberB[e];
+                break;
+            case ENGINE_DIFFERENCE:
+                expected = run->memberA[e] && !run->memberB[e];
+                break;
+            case ENGINE_SYMMETRIC_DIFFERENCE:
+                expected = !run->memberA[e] != !run->memberB[e];
+                break;
+            default:
+                expected = run->memberA[e];
+        }
+        if (expected) {
+            if (i >= count || run->buffer[i] != e) {
+                return 1;
+            }
+            i++;
+        }
+    }
+    return i != count;
+}
+
+/**
+ * Gibt eine Zeile der Tabelle aus.
+ *
+ * @param[in] run        die Messung.
+ * @param[in] op         die Operation.
+ * @param[in] t          die Zeitmessung.
+ * @param[in] mismatches Anzahl der Abweichungen.
+ */
+static void
+report (const Run * run, const char * op, Timing t, unsigned long mismatches) {
+    double ns = t.ops == 0 ? 0.0 : (double) t.clocks * 1e9 / CLOCKS_PER_SEC / (double) t.ops;
+
+    printf("%s,%s,%s,%lu,%.1f,%lu,%lu\n",
+           run->workload, run->engine->name, op, t.ops, ns, run->bytes, mismatches);
+    totalMismatches += mismatches;
+}
+
+/**
+ * Misst eine Bibliothek auf einer Last und prueft alle Ergebnisse.
+ *
+ * @param[in,out] run die Messung.
+ */
+static void
+measure (Run * run) {
+    static const char * combineNames[] = { "union", "intersection", "difference", "symmetric_difference" };
+    const Engine * engine = run->engine;
+    void * a = NULL;
+    void * b = NULL;
+    void * s = NULL;
+    Timing t;
+    clock_t start = 0;
+    unsigned long mismatches = 0, e = 0, i = 0, value = 0;
+    unsigned long cardA = run->countA;
+    int op = 0, subset = 1, equal = 1;
+
+    /* insert: Aufbau von a und b */
+    t.clocks = 0;
+    t.ops = 0;
+    do {
+        start = clock();
+        a = build(engine, run->elemsA, run->countA);
+        b = build(engine, run->elemsB, run->countB);
+        t.clocks += clock() - start;
+        t.ops += run->countA + run->countB;
+        if (t.clocks < minClocks) {
+            engine->destroy(a);
+            engine->destroy(b);
+        }
+    } while(t.clocks < minClocks);
+    mismatches = differs(run, a, -1) ? mismatch(run, "insert", "content of a") : 0;
+    run->bytes = engine->bytes(a);
+    report(run, "insert", t, mismatches);
+
+    /* contains */
+    t.clocks = 0;
+    t.ops = 0;
+    mismatches = 0;
+    do {
+        start = clock();
+        for(i = 0; i < HARNESS_QUERIES; i++){
+            value += (unsigned long) engine->contains(a, run->queries[i]);
+        }
+        t.clocks += clock() - start;
+        t.ops += HARNESS_QUERIES;
+    } while(t.clocks < minClocks);
+    for(i = 0; i < HARNESS_QUERIES; i++){
+        if (!engine->contains(a, run->queries[i]) != !run->memberA[run->queries[i]]) {
+            mismatches += mismatch(run, "contains", "membership");
+        }
+    }
+    report(run, "contains", t, mismatches);
+
+    /* cardinality */
+    t.clocks = 0;
+    t.ops = 0;
+    do {
+        start = clock();
+        value = engine->cardinality(a);
+        t.clocks += clock() - start;
+        t.ops++;
+    } while(t.clocks < minClocks);
+    report(run, "cardinality", t, value != cardA ? mismatch(run, "cardinality", "count") : 0);
+
+    /* min und max */
+    if (cardA > 0) {
+        for(e = 0; !run->memberA[e]; e++){
+        }
+        t.clocks = 0;
+        t.ops = 0;
+        do {
+            start = clock();
+            value = engine->min(a);
+            t.clocks += clock() - start;
+            t.ops++;
+        } while(t.clocks < minClocks);
+        report(run, "min", t, value != e ? mismatch(run, "min", "value") : 0);
+
+        for(e = UNIVERSE - 1; !run->memberA[e]; e--){
+        }
+        t.clocks = 0;
+        t.ops = 0;
+        do {
+            start = clock();
+            value = engine->max(a);
+            t.clocks += clock() - start;
+            t.ops++;
+        } while(t.clocks < minClocks);
+        report(run, "max", t, value != e ? mismatch(run, "max", "value") : 0);
+    }
+
+    /* subset und equals */
+    for(e = 0; e < UNIVERSE; e++){
+        if (run->memberA[e] && !run->memberB[e]) {
+            subset = 0;
+        }
+        if (!run->memberA[e] != !run->memberB[e]) {
+            equal = 0;
+        }
+    }
+    t.clocks = 0;
+    t.ops = 0;
+    do {
+        start = clock();
+        value = (unsigned long) engine->is_subset(a, b);
+        t.clocks += clock() - start;
+        t.ops++;
+    } while(t.clocks < minClocks);
+    report(run, "subset", t, (value != 0) != subset ? mismatch(run, "subset", "result") : 0);
+
+    t.clocks = 0;
+    t.ops = 0;
+    do {
+        start = clock();
+        value = (unsigned long) engine->equals(a, a) + (unsigned long) engine->equals(a, b);
+        t.clocks += clock() - start;
+        t.ops += 2;
+    } while(t.clocks < minClocks);
+    report(run, "equals", t, value != 1UL + (unsigned long) equal ? mismatch(run, "equals", "result") : 0);
+
+    /* Verknuepfungen */
+    for(op = ENGINE_UNION; op <= ENGINE_SYMMETRIC_DIFFERENCE; op++){
+        t.clocks = 0;
+        t.ops = 0;
+        do {
+            start = clock();
+            s = engine->combine(a, b, (EngineOp) op);
+            t.clocks += clock() - start;
+            t.ops++;
+            if (t.clocks < minClocks) {
+                engine->destroy(s);
+            }
+        } while(t.clocks < minClocks);
+        mismatches = differs(run, s, op) ? mismatch(run, combineNames[op], "content") : 0;
+        engine->destroy(s);
+        report(run, combineNames[op], t, mismatches);
+    }
+
+    /* remove: alle Elemente von b aus a entfernen */
+    t.clocks = 0;
+    t.ops = 0;
+    do {
+        if (t.ops > 0) {
+            engine->destroy(a);
+            a = build(engine, run->elemsA, run->countA);
+        }
+        start = clock();
+        for(i = 0; i < run->countB; i++){
+            engine->remove(a, run->elemsB[i]);
+        }
+        t.clocks += clock() - start;
+        t.ops += run->countB;
+    } while(t.clocks < minClocks && run->countB > 0);
+    report(run, "remove", t, differs(run, a, ENGINE_DIFFERENCE) ? mismatch(run, "remove", "content") : 0);
+
+    engine->destroy(a);
+    engine->destroy(b);
+}
+
+
+/**
+ * Hauptprogramm.
+ *
+ * Aufruf: harness [SEED [MS]], SEED initialisiert den Zufallsgenerator, MS ist
+ * die Mindestdauer einer Messung in Millisekunden.
+ *
+ * @param[in] argc Anzahl der Kommandozeilenargumente.
+ * @param[in] argv Array mit Kommandozeilenargumenten.
+ *
+ * @return EXIT_SUCCESS, falls alle Ergebnisse mit dem Modell uebereinstimmen.
+ */
+int
+main (int argc, char * argv[]) {
+    unsigned char * memberA = allocate(UNIVERSE);
+    unsigned char * memberB = allocate(UNIVERSE);
+    unsigned long * elemsA = allocate(UNIVERSE * sizeof(unsigned long));
+    unsigned long * elemsB = allocate(UNIVERSE * sizeof(unsigned long));
+    unsigned long * buffer = allocate(UNIVERSE * sizeof(unsigned long));
+    unsigned long queries[HARNESS_QUERIES];
+    unsigned long seed = 1, ms = HARNESS_DEFAULT_MS, i = 0;
+    size_t w = 0, k = 0;
+    Run run;
+
+    if (argc > 3 || (argc > 1 && sscanf(argv[1], "%lu", &seed) != 1)
+            || (argc > 2 && sscanf(argv[2], "%lu", &ms) != 1)) {
+        fprintf(stderr, "Usage: harness [SEED [MS]]\n");
+        return EXIT_FAILURE;
+    }
+    srand((unsigned int) seed);
+    minClocks = (clock_t) (ms * CLOCKS_PER_SEC / 1000);
+
+    printf("workload,engine,op,ops,ns_per_op,bytes_per_set,mismatches\n");
+
+    for(w = 0; w < WORKLOAD_COUNT; w++){
+        memset(memberA, 0, UNIVERSE);
+        memset(memberB, 0, UNIVERSE);
+        workloads[w].generate(memberA);
+        workloads[w].generate(memberB);
+
+        run.workload = workloads[w].name;
+        run.memberA = memberA;
+        run.memberB = memberB;
+        run.elemsA = elemsA;
+        run.countA = collect(memberA, elemsA);
+        run.elemsB = elemsB;
+        run.countB = collect(memberB, elemsB);
+        run.queries = queries;
+        run.buffer = buffer;
+        for(i = 0; i < HARNESS_QUERIES; i++){
+            queries[i] = randomBelow(UNIVERSE);
+        }
+
+        for(k = 0; k < ENGINE_COUNT; k++){
+            run.engine = engines[k];
+            measure(&run);
+        }
+        fflush(stdout);
+    }
+
+    free(memberA);
+    free(memberB);
+    free(elemsA);
+    free(elemsB);
+    free(buffer);
+
+    return totalMismatches == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,260 @@
+/**
+ * @file searchbench.c Vergleich der Suchverfahren fuer Intervall-Listen.
+ *
+ * Fuer Mengen mit wachsender Anzahl von Intervallen werden zufaellige Anfragen
+ * mit set_contains auf der Liste, mit der binaeren Suche des Index (setindex.h)
+ * und mit der Eytzinger-Anordnung des Index (setindex_eytzinger) beantwortet.
+ * Gemessen werden Enthaltensein (contains) und das erste Intervall, das nicht
+ * vor dem Element endet (lower_bound). Die Ergebnisse der Verfahren werden
+ * miteinander verglichen, die Messungen als CSV-Tabelle auf stdout ausgegeben.
+ *
+ * @author alexander loeffler, andre kloodt
+ */
+
+#include <time.h>
+
+#include "../Dynamic List Set/set.c"
+#include "../Dynamic List Set/setindex.c"
+
+/** Anzahl der Anfragen */
+#define SEARCH_QUERIES 65536
+
+/** Anzahl der Anfragen, nach der die Messzeit geprueft wird */
+#define SEARCH_BATCH 1024
+
+/** Anzahl der Anfragen an die Liste, deren Suche linear ist */
+#define SEARCH_LIST_QUERIES 64
+
+/** voreingestellte Mindestdauer einer Messung in Millisekunden */
+#define SEARCH_DEFAULT_MS 100
+
+/** Anzahl der Intervalle der gemessenen Mengen */
+static const unsigned long sizes[] = { 1000UL, 100000UL, 1000000UL, 4000000UL };
+
+/** Anzahl der Mengengroessen */
+#define SIZE_COUNT (sizeof(sizes) / sizeof(sizes[0]))
+
+/** Mindestdauer einer Messung in Takten von clock */
+static clock_t minClocks = 0;
+
+/** Gesamtzahl der Abweichungen */
+static unsigned long totalMismatches = 0;
+
+/** nimmt die Ergebnisse der Anfragen auf, damit sie nicht wegoptimiert werden */
+static volatile unsigned long sink = 0;
+
+/**
+ * Die gemessenen Mengen und Anfragen.
+ */
+typedef struct {
+    /** die Menge als Liste */
+    Set set;
+    /** Index mit binaerer Suche */
+    SetIndex binary;
+    /** Index mit Eytzinger-Anordnung */
+    SetIndex eytzinger;
+    /** die Anfragen */
+    Element queries[SEARCH_QUERIES];
+} Bench;
+
+
+/**
+ * Liefert eine Zufallszahl aus [0, n).
+ *
+ * @param[in] n obere Grenze.
+ *
+ * @return die Zufallszahl.
+ */
+static unsigned long
+randomBelow (unsigned long n) {
+    unsigned long r = ((unsigned long) rand() << 15) ^ (unsigned long) rand();
+
+    return r % n;
+}
+
+/**
+ * Baut eine Menge aus count Intervallen mit zufaelligen Laengen (1 bis 4) und
+ * Luecken (1 bis 4) auf und erzeugt Anfragen, die gleichverteilt ueber den
+ * belegten Bereich streuen.
+ *
+ * @param[out] bench die Mengen und Anfragen.
+ * @param[in]  count Anzahl der Intervalle.
+ */
+static void
+prepareBench (Bench * bench, unsigned long count) {
+    SetBuilder builder;
+    Element pos = 0, length = 0;
+    unsigned long i = 0;
+
+    set_builder_init(&builder);
+    for(i = 0; i < count; i++){
+        pos += 1 + (Element) randomBelow(4);
+        length = (Element) randomBelow(4);
+        set_builder_append_range(&builder, pos, pos + length);
+        pos += length + 1;
+    }
+    bench->set = set_builder_finish(&builder);
+
+    bench->binary = setindex_create(bench->set);
+    bench->eytzinger = setindex_create(bench->set);
+    setindex_eytzinger(&bench->eytzinger);
+
+    for(i = 0; i < SEARCH_QUERIES; i++){
+        bench->queries[i] = (Element) randomBelow((unsigned long) pos + 2);
+    }
+}
+
+/**
+ * Gibt die Mengen frei.
+ *
+ * @param[in,out] bench die Mengen.
+ */
+static void
+releaseBench (Bench * bench) {
+    bench->set = set_clear(bench->set);
+    setindex_delete(&bench->binary);
+    setindex_delete(&bench->eytzinger);
+}
+
+/**
+ * Gibt eine Zeile der Tabelle aus.
+ *
+ * @param[in] count      Anzahl der Intervalle.
+ * @param[in] method     das Suchverfahren.
+ * @param[in] op         die Anfrage.
+ * @param[in] clocks     verbrauchte Takte.
+ * @param[in] ops        Anzahl der Anfragen.
+ * @param[in] mismatches Anzahl der Abweichungen.
+ */
+static void
+report (unsigned long count, const char * method, const char * op,
+        clock_t clocks, unsigned long ops, unsigned long mismatches) {
+    double ns = ops == 0 ? 0.0 : (double) clocks * 1e9 / CLOCKS_PER_SEC / (double) ops;
+
+    printf("%lu,%s,%s,%lu,%.1f,%lu\n", count, method, op, ops, ns, mismatches);
+    totalMismatches += mismatches;
+}
+
+/**
+ * Misst set_contains auf der Liste.
+ *
+ * @param[in] bench die Mengen und Anfragen.
+ * @param[in] count Anzahl der Intervalle.
+ */
+static void
+measureList (const Bench * bench, unsigned long count) {
+    clock_t clocks = 0, start = 0;
+    unsigned long ops = 0, i = 0, hits = 0;
+
+    do {
+        start = clock();
+        for(i = 0; i < SEARCH_LIST_QUERIES; i++){
+            hits += (unsigned long) set_contains(bench->set, bench->queries[(ops + i) % SEARCH_QUERIES]);
+        }
+        clocks += clock() - start;
+        ops += SEARCH_LIST_QUERIES;
+    } while(clocks < minClocks);
+
+    sink += hits;
+    report(count, "list", "contains", clocks, ops, 0);
+}
+
+/**
+ * Misst contains und lower_bound auf einem Index.
+ *
+ * @param[in] bench  die Mengen und Anfragen.
+ * @param[in] idx    der Index.
+ * @param[in] method Name des Suchverfahrens.
+ * @param[in] count  Anzahl der Intervalle.
+ */
+static void
+measureIndex (const Bench * bench, const SetIndex * idx, const char * method, unsigned long count) {
+    clock_t clocks = 0, start = 0;
+    unsigned long ops = 0, i = 0, sum = 0, mismatches = 0;
+
+    do {
+        start = clock();
+        for(i = 0; i < SEARCH_BATCH; i++){
+            sum += (unsigned long) setindex_contains(idx, bench->queries[(ops + i) % SEARCH_QUERIES]);
+        }
+        clocks += clock() - start;
+        ops += SEARCH_BATCH;
+    } while(clocks < minClocks);
+    for(i = 0; i < SEARCH_QUERIES; i++){
+        if (setindex_contains(idx, bench->queries[i]) != setindex_contains(&bench->binary, bench->queries[i])) {
+            mismatches++;
+        }
+    }
+    /* die Liste ist die Referenz, wegen ihrer linearen Suche nur fuer wenige Anfragen */
+    for(i = 0; i < SEARCH_LIST_QUERIES; i++){
+        if (setindex_contains(idx, bench->queries[i]) != set_contains(bench->set, bench->queries[i])) {
+            mismatches++;
+        }
+    }
+    report(count, method, "contains", clocks, ops, mismatches);
+
+    clocks = 0;
+    ops = 0;
+    mismatches = 0;
+    do {
+        start = clock();
+        for(i = 0; i < SEARCH_BATCH; i++){
+            sum += setindex_lower_bound(idx, bench->queries[(ops + i) % SEARCH_QUERIES]);
+        }
+        clocks += clock() - start;
+        ops += SEARCH_BATCH;
+    } while(clocks < minClocks);
+    for(i = 0; i < SEARCH_QUERIES; i++){
+        if (setindex_lower_bound(idx, bench->queries[i])
+                != setindex_lower_bound(&bench->binary, bench->queries[i])) {
+            mismatches++;
+        }
+    }
+    sink += sum;
+    report(count, method, "lower_bound", clocks, ops, mismatches);
+}
+
+/**
+ * Hauptprogramm.
+ *
+ * Optional koennen der Startwert des Zufallsgenerators und die Mindestdauer
+ * einer Messung in Millisekunden angegeben werden.
+ *
+ * @param[in] argc Anzahl der Kommandozeilenargumente.
+ * @param[in] argv Array mit Kommandozeilenargumenten.
+ *
+ * @return EXIT_SUCCESS, falls alle Verfahren dieselben Ergebnisse liefern.
+ */
+int
+main (int argc, char * argv[]) {
+    Bench * bench = malloc(sizeof(Bench));
+    unsigned long seed = 1, ms = SEARCH_DEFAULT_MS;
+    size_t k = 0;
+
+    if (bench == NULL) {
+        exit(ERR_OUT_OF_MEMORY);
+    }
+    if (argc > 3 || (argc > 1 && sscanf(argv[1], "%lu", &seed) != 1)
+            || (argc > 2 && sscanf(argv[2], "%lu", &ms) != 1)) {
+        fprintf(stderr, "Usage: searchbench [SEED [MS]]\n");
+        free(bench);
+        return EXIT_FAILURE;
+    }
+    srand((unsigned int) seed);
+    minClocks = (clock_t) (ms * CLOCKS_PER_SEC / 1000);
+
+    printf("intervals,method,op,ops,ns_per_op,mismatches\n");
+
+    for(k = 0; k < SIZE_COUNT; k++){
+        prepareBench(bench, sizes[k]);
+        measureList(bench, sizes[k]);
+        measureIndex(bench, &bench->binary, "binary", sizes[k]);
+        measureIndex(bench, &bench->eytzinger, "eytzinger", sizes[k]);
+        releaseBench(bench);
+        fflush(stdout);
+    }
+
+    free(bench);
+
+    return totalMismatches == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,300 @@
+/**
+ * @file streamcheck.c Pruefung der Verknuepfung von Intervall-Dateien
+ * (setstream.h).
+ *
+ * Fuer zufaellige Mengen werden die Intervalle in beiden Formaten in temporaere
+ * Dateien geschrieben, wobei jedes Intervall in sich ueberlappende oder
+ * aneinander grenzende Stuecke zerlegt wird. Das Ergebnis von
+ * setstream_combine wird eingelesen und mit set_combine verglichen.
+ *
+ * Zusaetzlich werden fehlerhafte Textdateien (unsortierte Zeile, falsche
+ * Syntax) verknuepft: Alle Intervalle vor dem fehlerhaften Eintrag muessen
+ * geschrieben und der Fehler mit seiner Zeile gemeldet werden.
+ *
+ * @author alexander loeffler, andre kloodt
+ */
+
+#include "../Dynamic List Set/set.c"
+#include "../Dynamic List Set/setstream.c"
+
+/** Anzahl der zufaelligen Mengenpaare */
+#define CHECK_ROUNDS 200
+
+/** groesstes Element der zufaelligen Mengen */
+#define CHECK_MAX_ELEM 4096
+
+/** Gesamtzahl der Abweichungen */
+static unsigned long totalMismatches = 0;
+
+/**
+ * Eine fehlerhafte Textdatei und die Intervalle vor dem Fehler.
+ */
+typedef struct {
+    /** Name in der Ausgabe */
+    const char * name;
+    /** Inhalt der Datei */
+    const char * text;
+    /** Intervalle vor dem Fehler in der kanonischen Textform */
+    const char * expected;
+    /** Zeile des fehlerhaften Eintrags */
+    unsigned long line;
+} BrokenInput;
+
+/** die fehlerhaften Dateien */
+static const BrokenInput broken[] = {
+    { "syntax", "1 2\n5 6\n10 11\nx y\n", "1 2\n5 6\n10 11\n", 4 },
+    { "unsorted", "1 2\n5 6\n3 4\n", "1 2\n5 6\n", 3 },
+    { "unsorted_merged", "1 2\n3 6\n0 1\n", "1 6\n", 3 },
+    { "reversed", "1 2\n\n7 5\n", "1 2\n", 3 },
+    { "trailing", "1 2\n4 5 6\n", "1 2\n", 2 },
+    { "first", "z\n1 2\n", "", 1 }
+};
+
+/** Anzahl der fehlerhaften Dateien */
+#define BROKEN_COUNT (sizeof(broken) / sizeof(broken[0]))
+
+
+/**
+ * Liefert eine Zufallszahl aus [0, n).
+ *
+ * @param[in] n obere Grenze.
+ *
+ * @return die Zufallszahl.
+ */
+static unsigned long
+randomBelow (unsigned long n) {
+    unsigned long r = ((unsigned long) rand() << 15) ^ (unsigned long) rand();
+
+    return r % n;
+}
+
+/**
+ * Oeffnet eine temporaere Datei und beendet das Programm, falls das nicht
+ * moeglich ist.
+ *
+ * @return die Datei.
+ */
+static FILE *
+openTemp (void) {
+    FILE * file = tmpfile();
+
+    if (file == NULL) {
+        fprintf(stderr, "cannot create a temporary file\n");
+        exit(EXIT_FAILURE);
+    }
+    return file;
+}
+
+/**
+ * Erzeugt eine zufaellige Menge aus Bloecken mit Luecken.
+ *
+ * @return die Menge.
+ */
+static Set
+randomSet (void) {
+    SetBuilder builder;
+    Element e = (Element) randomBelow(64);
+    Element length = 0;
+
+    set_builder_init(&builder);
+    while(e < CHECK_MAX_ELEM){
+        length = (Element) randomBelow(randomBelow(2) == 0 ? 4 : 200);
+        set_builder_append_range(&builder, e, e + length);
+        e += length + 2 + (Element) randomBelow(100);
+    }
+    return set_builder_finish(&builder);
+}
+
+/**
+ * Schreibt die Intervalle einer Menge in eine Datei. Jedes Intervall wird in
+ * Stuecke zerlegt, die sich ueberlappen oder aneinander grenzen.
+ *
+ * @param[in] s      die Menge.
+ * @param[in] file   die Datei.
+ * @param[in] format das Format der Datei.
+ */
+static void
+writeSplit (Set s, FILE * file, SetStreamFormat format) {
+    SetFileWriter * writer = malloc(sizeof(SetFileWriter));
+    SetSink sink;
+    SetListCursor cursor;
+    SetSource src = set_source_list(&cursor, s);
+    Element start = 0, end = 0, cut = 0;
+
+    if (writer == NULL) {
+        exit(ERR_OUT_OF_MEMORY);
+    }
+    /* die Senke schreibt die Stuecke so, wie sie uebergeben werden */
+    sink = setstream_sink(writer, file, format);
+    while(src.next(src.state, &start, &end)){
+        while(start < end && randomBelow(2) == 0){
+            cut = start + (Element) randomBelow((unsigned long) (end - start));
+            sink.emit(sink.state, start, cut);
+            start = cut + (Element) randomBelow(2);
+        }
+        sink.emit(sink.state, start, end);
+    }
+    setstream_flush(writer);
+    rewind(file);
+    free(writer);
+}
+
+/**
+ * Liest eine Intervall-Datei als Menge ein.
+ *
+ * @param[in]  file   die Datei.
+ * @param[in]  format das Format der Datei.
+ * @param[out] status Ergebnis des Lesens.
+ *
+ * @return die Menge.
+ */
+static Set
+readSet (FILE * file, SetStreamFormat format, SetStreamStatus * status) {
+    SetFileCursor * cursor = malloc(sizeof(SetFileCursor));
+    SetSource src;
+    Element start = 0, end = 0;
+    SetBuilder builder;
+    Set result = EMPTY_SET;
+
+    if (cursor == NULL) {
+        exit(ERR_OUT_OF_MEMORY);
+    }
+    rewind(file);
+    src = setstream_source(cursor, file, format);
+    set_builder_init(&builder);
+    while(src.next(src.state, &start, &end)){
+        set_builder_append_range(&builder, start, end);
+    }
+    result = set_builder_finish(&builder);
+    *status = cursor->status;
+    free(cursor);
+    return result;
+}
+
+/**
+ * Verknuepft zufaellige Mengen ueber Dateien und vergleicht das Ergebnis mit
+ * set_combine.
+ *
+ * @param[in] format das Format der Dateien.
+ */
+static void
+checkRandom (SetStreamFormat format) {
+    static const SetOp ops[] = { SET_OP_UNION, SET_OP_INTERSECTION, SET_OP_DIFFERENCE,
+                                 SET_OP_REVERSE_DIFFERENCE, SET_OP_SYMMETRIC_DIFFERENCE };
+    Set a = EMPTY_SET, b = EMPTY_SET, expected = EMPTY_SET, actual = EMPTY_SET;
+    FILE * fileA = NULL;
+    FILE * fileB = NULL;
+    FILE * out = NULL;
+    SetStreamStatus status = SETSTREAM_OK, readStatus = SETSTREAM_OK;
+    unsigned long round = 0, mismatches = 0;
+    size_t k = 0;
+
+    for(round = 0; round < CHECK_ROUNDS; round++){
+        a = randomSet();
+        b = randomBelow(8) == 0 ? EMPTY_SET : randomSet();
+        for(k = 0; k < sizeof(ops) / sizeof(ops[0]); k++){
+            fileA = openTemp();
+            fileB = openTemp();
+            out = openTemp();
+            writeSplit(a, fileA, format);
+            writeSplit(b, fileB, format);
+
+            status = setstream_combine(fileA, fileB, out, ops[k], format, NULL);
+            expected = set_combine(a, b, ops[k]);
+            actual = readSet(out, format, &readStatus);
+            if (status != SETSTREAM_OK || readStatus != SETSTREAM_OK || !set_equals(expected, actual)) {
+                fprintf(stderr, "mismatch: format=%s round=%lu op=%d\n",
+                        format == SETSTREAM_BINARY ? "binary" : "text", round, (int) ops[k]);
+                mismatches++;
+            }
+            expected = set_clear(expected);
+            actual = set_clear(actual);
+            fclose(fileA);
+            fclose(fileB);
+            fclose(out);
+        }
+        a = set_clear(a);
+        b = set_clear(b);
+    }
+
+    printf("random_%s,%lu,%lu\n", format == SETSTREAM_BINARY ? "binary" : "text",
+           (unsigned long) CHECK_ROUNDS * (sizeof(ops) / sizeof(ops[0])), mismatches);
+    totalMismatches += mismatches;
+}
+
+/**
+ * Verknuepft eine leere Datei mit einer fehlerhaften Datei und prueft, dass
+ * alle Intervalle vor dem Fehler geschrieben und der Fehler mit der zweiten
+ * Eingabe und seiner Zeile gemeldet wurden.
+ *
+ * @param[in] input die fehlerhafte Datei.
+ */
+static void
+checkBroken (const BrokenInput * input) {
+    FILE * fileA = openTemp();
+    FILE * fileB = openTemp();
+    FILE * out = openTemp();
+    char text[256];
+    size_t length = 0;
+    SetStreamStatus status = SETSTREAM_OK;
+    SetStreamLocation where;
+    unsigned long mismatches = 0;
+
+    fputs(input->text, fileB);
+    rewind(fileB);
+    status = setstream_combine(fileA, fileB, out, SET_OP_UNION, SETSTREAM_TEXT, &where);
+
+    rewind(out);
+    length = fread(text, 1, sizeof(text) - 1, out);
+    text[length] = '\0';
+    if (status != SETSTREAM_INVALID_INPUT) {
+        fprintf(stderr, "mismatch: input=%s: error not reported\n", input->name);
+        mismatches++;
+    } else if (where.input != 2 || where.line != input->line) {
+        fprintf(stderr, "mismatch: input=%s: error reported at input %d line %lu\n",
+                input->name, where.input, where.line);
+        mismatches++;
+    }
+    if (strcmp(text, input->expected) != 0) {
+        fprintf(stderr, "mismatch: input=%s: output \"%s\"\n", input->name, text);
+        mismatches++;
+    }
+
+    fclose(fileA);
+    fclose(fileB);
+    fclose(out);
+
+    printf("broken_%s,1,%lu\n", input->name, mismatches);
+    totalMismatches += mismatches;
+}
+
+/**
+ * Hauptprogramm.
+ *
+ * Optional kann der Startwert des Zufallsgenerators angegeben werden.
+ *
+ * @param[in] argc Anzahl der Kommandozeilenargumente.
+ * @param[in] argv Array mit Kommandozeilenargumenten.
+ *
+ * @return EXIT_SUCCESS, falls alle Ergebnisse den Erwartungen entsprechen.
+ */
+int
+main (int argc, char * argv[]) {
+    unsigned long seed = 1;
+    size_t k = 0;
+
+    if (argc > 2 || (argc > 1 && sscanf(argv[1], "%lu", &seed) != 1)) {
+        fprintf(stderr, "Usage: streamcheck [SEED]\n");
+        return EXIT_FAILURE;
+    }
+    srand((unsigned int) seed);
+
+    printf("case,checks,mismatches\n");
+    checkRandom(SETSTREAM_TEXT);
+    checkRandom(SETSTREAM_BINARY);
+    for(k = 0; k < BROKEN_COUNT; k++){
+        checkBroken(&broken[k]);
+    }
+
+    return totalMismatches == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}